@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ALLOC_CHECK_WARMUP 200  // headless ticks before the check (first spawns, deque chunks)
+#define ALLOC_CHECK_TICKS 5000  // headless ticks that must not allocate
+
+namespace AllocSubsystem {
+	enum Enum {
+		OTHER,  // outside of the game loop phases
+		INPUT,
+		MOVE,  // snakes & AI
+		FOOD_BONUS,
+		UPDATE,  // _update (single / multi player rules)
+		SOUND,
+		DRAW,
+		NB_SUBSYSTEMS,
+	};
+}
+
+/*
+	count the allocations of each thread (global operator new, replaced in AllocTracker.cpp)
+	the dlopen'd GUIs & sound libraries allocate through the same operator new
+	the counters are thread_local: counting is a few increments, no lock & no shared cache line
+	the game thread sets the current subsystem at each phase of the loop, tick() keeps the counts of each tick
+*/
+class AllocTracker {
+	public:
+		struct Counts {
+			uint64_t	nbAllocs;
+			uint64_t	nbBytes;
+		};
+
+		AllocTracker();
+		virtual ~AllocTracker();
+		AllocTracker(AllocTracker const &src);
+		AllocTracker &operator=(AllocTracker const &rhs);
+
+		/* current thread: the next allocations are counted in subsystem */
+		static void		setSubsystem(AllocSubsystem::Enum subsystem);
+		static Counts	get(AllocSubsystem::Enum subsystem);  // current thread, since its start
+		static void		count(size_t size);  // called by operator new
+
+		/* game thread: add the allocations since the last tick, return the allocations of the tick */
+		uint64_t	tick();
+		void		reset();  // forget the previous ticks (warmup)
+		void		report() const;
+
+	private:
+		struct Subsystem {
+			uint64_t	nbAllocs;
+			uint64_t	nbBytes;
+			uint64_t	maxAllocs;  // in one tick
+			uint64_t	nbTicksAllocating;
+		};
+
+		Counts		_last[AllocSubsystem::NB_SUBSYSTEMS];
+		Subsystem	_subsystems[AllocSubsystem::NB_SUBSYSTEMS];
+		uint64_t	_nbTicks;
+};
@@ -4,23 +4,30 @@
 #include <vector>
 #include <utility>
 #include <stdexcept>
+#include <future>
 
 #include "Logging.hpp"
+#include "Tracer.hpp"
 
 #define NO_DYN_LOADED 255
 
-
+/*
+	DynManager load the dynamic libraries (dlopen) and construct their object
+	in resident mode, each library is loaded and constructed only once and kept alive:
+	load only swap obj on the already loaded library (use preload to dlopen it in background)
+*/
 template<class T>
 class DynManager {
 	public:
-		DynManager() : obj(nullptr), _currentID(NO_DYN_LOADED), _hndl(nullptr) {}
+		DynManager() : obj(nullptr), _currentID(NO_DYN_LOADED), _resident(false), _tracer(nullptr) {}
 		virtual ~DynManager() {
-			unload();
+			unloadAll();
 		}
-		DynManager(DynManager const &src) { *this = src; }
+		DynManager(DynManager const &src) : DynManager() { *this = src; }
 		DynManager &operator=(DynManager const &rhs) {
 			if (this != &rhs) {
 				_currentID = rhs._currentID;
+				_resident = rhs._resident;
 			}
 			return *this;
 		}
@@ -35,45 +42,128 @@ class DynManager {
 		T *		obj;
 
 		typedef T * (*createPtr)();
-		void		load(uint8_t id) {
+		/*
+		set obj on the dyn id (load it if needed)
+		return true if obj was just constructed (need init), false if it was already resident
+		*/
+		bool		load(uint8_t id) {
+			TRACE_SCOPE(_tracer, "DynManager::load", id);
+			if (id >= _infos.size()) {
+				throw DynManagerException("invalid dyn id");
+			}
 			// quit current dyn before loading a new one
-			unload();
-
-			// load library
-			_hndl = dlopen(_infos[id].first.c_str(), RTLD_LAZY);
-			if (_hndl == NULL) {
-				throw DynManagerException(dlerror());
+			if (!_resident) {
+				unload();
 			}
 
-			// get the correct creator
-			void *	mkr = dlsym(_hndl, _infos[id].second.c_str());
-			if (mkr == NULL) {
-				throw DynManagerException(dlerror());
-			}
+			Dyn & dyn = _dyns[id];
+			bool created = false;
+			if (dyn.obj == nullptr) {
+				// load library (or wait for the preload)
+				if (dyn.preload.valid()) {
+					dyn.hndl = dyn.preload.get();
+				}
+				if (dyn.hndl == nullptr) {
+					dyn.hndl = _open(_infos[id].first, _tracer);
+				}
 
-			// construct the gui
-			obj = reinterpret_cast<createPtr>(mkr)();
+				// get the correct creator
+				void *	mkr = dlsym(dyn.hndl, _infos[id].second.c_str());
+				if (mkr == NULL) {
+					throw DynManagerException(dlerror());
+				}
 
+				// construct the gui
+				dyn.obj = reinterpret_cast<createPtr>(mkr)();
+				created = true;
+			}
+			obj = dyn.obj;
 			_currentID = id;
+			return created;
+		}
+		/*
+		start to dlopen the dyn id in background (resident mode only)
+		the object is constructed on the next load(id)
+		*/
+		void		preload(uint8_t id) {
+			if (!_resident || id >= _infos.size())
+				return;
+			Dyn & dyn = _dyns[id];
+			if (dyn.hndl != nullptr || dyn.preload.valid())
+				return;
+			dyn.preload = std::async(std::launch::async, &DynManager::_open, _infos[id].first, _tracer);
 		}
+		/* unload the current dyn (in resident mode, it stay loaded, use unloadAll) */
 		void		unload() {
 			if (_currentID != NO_DYN_LOADED) {
-				delete obj;
-				dlclose(_hndl);
-
+				if (!_resident) {
+					_close(_dyns[_currentID]);
+				}
+				obj = nullptr;
 				_currentID = NO_DYN_LOADED;
 			}
 		}
+		void		unloadAll() {
+			// the current dyn is deleted last
+			for (uint8_t id = 0; id < _dyns.size(); id++) {
+				if (id != _currentID)
+					_close(_dyns[id]);
+			}
+			if (_currentID != NO_DYN_LOADED)
+				_close(_dyns[_currentID]);
+			obj = nullptr;
+			_currentID = NO_DYN_LOADED;
+		}
 		uint8_t		getCurrentID() const { return _currentID; }
 		uint8_t		getNbDyn() const { return _infos.size(); }
+		bool		isLoaded(uint8_t id) const { return id < _dyns.size() && _dyns[id].obj != nullptr; }
+
+		void		setResident(bool resident) { _resident = resident; }
+		void		setTracer(Tracer * tracer) { _tracer = tracer; }
+		bool		isResident() const { return _resident; }
 
 		int		addDyn(std::string const & libFile, std::string const & creatorName) {
 			_infos.push_back(std::pair<std::string const, std::string const>(libFile, creatorName));
+			_dyns.push_back(Dyn());
 			return _infos.size() - 1;  // return the ID
 		}
 
 	private:
+		struct Dyn {
+			void *				hndl;
+			T *					obj;
+			std::future<void *>	preload;  // background dlopen
+
+			Dyn() : hndl(nullptr), obj(nullptr), preload() {}
+		};
+
+		static void	*_open(std::string const & libFile, Tracer * tracer) {
+			TRACE_SCOPE(tracer, "dlopen");
+			void * hndl = dlopen(libFile.c_str(), RTLD_LAZY);
+			if (hndl == NULL) {
+				throw DynManagerException(dlerror());
+			}
+			return hndl;
+		}
+		static void	_close(Dyn & dyn) {
+			if (dyn.preload.valid()) {
+				try {
+					dyn.hndl = dyn.preload.get();
+				}
+				catch (DynManagerException const & e) {
+					logErr(e.what());
+				}
+			}
+			delete dyn.obj;
+			dyn.obj = nullptr;
+			if (dyn.hndl != nullptr)
+				dlclose(dyn.hndl);
+			dyn.hndl = nullptr;
+		}
+
 		uint8_t		_currentID;
-		void		*_hndl;
+		bool		_resident;
+		Tracer *	_tracer;  // owned by the game, null if not set
 		std::vector<std::pair<std::string const, std::string const>> _infos;
+		std::vector<Dyn>	_dyns;
 };
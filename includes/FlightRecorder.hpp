@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#else
+	#include <chrono>
+#endif
+
+#define FLIGHT_RECORDER_SIZE (1 << 15)  // events in the ring (power of 2), ~1min of game at 60fps
+#define FLIGHT_RECORDER_PATH_SIZE 256
+#define FLIGHT_DUMP_INTERVAL_MS 10000  // min time between two dumps on slow frames
+
+namespace FlightEvent {
+	enum Enum {
+		TICK_START,  // a: nbMoves
+		TICK_END,  // b: frame time in ms
+		SLOW_FRAME,  // b: frame time in ms
+		INPUT,  // a: player id or 0, b: InputType
+		GUI_SWITCH,  // a: old gui id, b: new gui id
+		SPAWN_FOOD,  // a: nb tries, b: 1 if spawned
+		SPAWN_BONUS,  // a: nb tries, b: 1 if spawned
+		SETTINGS_RELOAD,
+		NB_EVENTS,
+	};
+	enum InputType {
+		DIRECTION_UP,  // same values as Direction::Enum
+		DIRECTION_DOWN,
+		DIRECTION_LEFT,
+		DIRECTION_RIGHT,
+		PAUSE,
+		UNPAUSE,
+		RESTART,
+		QUIT,
+	};
+}
+
+/*
+	always-on ring of the last binary game events, overwritten in loop
+	record() is a 16 bytes store without lock or atomic increment, the timestamps are raw cpu ticks
+	dump() only uses async-signal-safe functions: it is called on crash (SIGSEGV, SIGABRT, ...)
+	on slow frames, the ring is copied and written by a background thread: the frame is not made longer
+*/
+class FlightRecorder {
+	public:
+		FlightRecorder();
+		virtual ~FlightRecorder();
+		FlightRecorder(FlightRecorder const &src);
+		FlightRecorder &operator=(FlightRecorder const &rhs);
+
+		/* set the dump file and install the crash handlers */
+		bool	start(std::string const & filename);
+		bool	dump(char const * reason);
+		/* dump at most once every FLIGHT_DUMP_INTERVAL_MS, in background (game thread only) */
+		bool	dumpSlowFrame(uint32_t frameMs);
+
+		/* game thread only (single writer) */
+		inline void	record(FlightEvent::Enum type, uint16_t a = 0, uint32_t b = 0) {
+			uint64_t pos = _writePos.load(std::memory_order_relaxed);
+			Event & event = _events[pos & (FLIGHT_RECORDER_SIZE - 1)];
+			event.ticks = _ticks();
+			event.type = type;
+			event.a = a;
+			event.b = b;
+			_writePos.store(pos + 1, std::memory_order_release);
+		}
+
+	private:
+		struct Event {
+			uint64_t	ticks;
+			uint16_t	type;
+			uint16_t	a;
+			uint32_t	b;
+		};
+
+		Event					_events[FLIGHT_RECORDER_SIZE];
+		Event					_snapshot[FLIGHT_RECORDER_SIZE];  // copy of _events written by _dumpThread
+		std::thread				_dumpThread;
+		std::atomic<bool>		_dumping;  // true while _dumpThread writes _snapshot
+		std::atomic<uint64_t>	_writePos;  // read by the signal handler
+		uint64_t				_startTicks;
+		uint64_t				_startNs;
+		uint64_t				_lastDumpNs;
+		char					_filename[FLIGHT_RECORDER_PATH_SIZE];  // no allocation in the signal handler
+
+		static inline uint64_t	_ticks() {
+			#if defined(__x86_64__) || defined(__i386__)
+				return __rdtsc();
+			#else
+				return std::chrono::steady_clock::now().time_since_epoch().count();
+			#endif
+		}
+		bool			_write(Event const * events, uint64_t end, char const * reason);
+		void			_dumpSnapshot(uint64_t end, uint32_t frameMs);
+		static uint64_t	_nowNs();
+		static void		_signalHandler(int sig);
+};
+
+extern FlightRecorder	flightRecorder;
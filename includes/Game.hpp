@@ -1,8 +1,28 @@
 #pragma once
 
+#include <chrono>
+
 #include "ANibblerGui.hpp"
 #include "ANibblerSound.hpp"
+#include "SoundAssetCache.hpp"
 #include "DynManager.hpp"
+#include "nibbler.hpp"
+#include "SettingsWatcher.hpp"
+#include "Tracer.hpp"
+#include "PerfCounters.hpp"
+#include "Metrics.hpp"
+#include "AllocTracker.hpp"
+
+namespace GameSound {
+	enum Enum {
+		WIN,
+		LOOSE,
+		EAT,
+		BONUS,
+		WALL,
+		NB_SOUNDS,
+	};
+}
 
 class Game {
 	public:
@@ -14,6 +34,8 @@ class Game {
 
 		bool	init();
 		void	run();
+		bool	checkAllocs();  // headless run, false if a tick allocates after the warmup
+		Tracer &	getTracer() { return _tracer; }
 		void	restart();
 
 		DynManager<ANibblerSound>		dynSoundManager;
@@ -26,12 +48,29 @@ class Game {
 		};
 
 	private:
+		GameSettings					_settings;  // copy of the settings used in the game loop
+		SettingsWatcher					_settingsWatcher;
 		GameInfo *						_gameInfo;
 		std::vector<uint8_t>			_needExtend;
 		std::vector<Vec2>				_lastDeletedSnake;
 		std::deque<Vec2>				_wall;
 		uint32_t						_speedMs;
+		SoundAssetCache					_soundCache;  // decoded sounds kept across sound backend reloads
+		SoundHandle						_sounds[GameSound::NB_SOUNDS];  // resolved on each sound backend change
+		Tracer							_tracer;  // spans of the game & the GUIs (enabled with --trace)
+		PerfCounters					_perf;  // hardware counters per phase (enabled with --perf-counters)
+		Metrics							_metrics;  // live counters, served with --metrics
+		AllocTracker					_allocs;  // allocations per tick & phase (reported with --alloc-report)
+		uint64_t *						_highScore;  // resolved once: no settings lookup in the game loop
+		float							_loopTime;  // ms per frame (1000 / fps)
+		uint32_t						_lastMoveTime;
+		uint32_t						_nbMoves;
+		std::chrono::steady_clock::time_point	_nextFrame;  // deadline of the next draw (1 / fps)
+		bool							_firstLoop;
+		bool							_fixedStep;  // headless check: move & draw on each tick, no frame rate
 
+		void				_initGameInfo();
+		uint64_t			_tick();
 		void				_move(Direction::Enum direction, int id);
 		void				_moveIA(Direction::Enum lastDir, int id);
 		void				_updateFood();
@@ -41,4 +80,6 @@ class Game {
 		void				_updateSinglePlayer();
 		void				_updateMultiPlayer();
 		void				_changeGui(int guiID, int soundID);
+		void				_loadSoundAssets();
+		void				_playSound(GameSound::Enum sound, int channel = -1);
 };
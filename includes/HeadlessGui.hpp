@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ANibblerGui.hpp"
+
+/*
+	GUI without window for the headless runs (--check-allocs): draw nothing, the input only restart the game
+	after a game over (all the snakes are played by the AI)
+*/
+class HeadlessGui : public ANibblerGui {
+	public:
+		HeadlessGui();
+		virtual ~HeadlessGui();
+		HeadlessGui(HeadlessGui const &src);
+		HeadlessGui &operator=(HeadlessGui const &rhs);
+
+		virtual void	updateInput();
+		virtual bool	draw();
+		virtual void	waitInput(uint32_t timeoutUs);
+
+	private:
+		virtual bool	_init();
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "ANibblerSound.hpp"
+
+#define METRICS_NB_BUCKETS 9  // frame time buckets, +Inf is added
+#define METRICS_REQUEST_SIZE 4096  // max size of a scrape request
+#define METRICS_TIMEOUT_MS 1000  // a client slower than this is disconnected
+
+/*
+	live counters of the game, served in the prometheus text format on a unix socket
+	the game thread only updates relaxed atomics (never blocks, no allocation)
+	a background thread answers the scrapes: it only reads the atomics, the game loop is never touched
+	curl --unix-socket nibbler.sock http://localhost/metrics
+*/
+class Metrics {
+	public:
+		Metrics();
+		virtual ~Metrics();
+		Metrics(Metrics const &src);
+		Metrics &operator=(Metrics const &rhs);
+
+		bool	start(std::string const & socketPath);
+		void	stop();
+
+		/* game thread */
+		void	addFrame(uint64_t frameUs, bool late, bool overBudget, bool drawn);
+		void	addMove() { _add(_nbMoves, 1); }
+		void	addAIDecision(uint64_t durationNs) { _add(_nbAIDecisions, 1); _add(_aiDecisionNs, durationNs); }
+		void	setSnakesAlive(uint64_t nbAlive) { _snakesAlive.store(nbAlive, std::memory_order_relaxed); }
+		void	addSpawn(uint64_t nbTries, bool spawned);
+		void	addGuiSwitch(uint64_t durationUs) { _add(_nbGuiSwitches, 1); _add(_guiSwitchUs, durationUs); }
+		void	setSoundStats(SoundStats const & stats);
+
+		/* prometheus text exposition */
+		std::string	format() const;
+
+	private:
+		// single writer: load + store is enough, the scrape thread only reads
+		static void	_add(std::atomic<uint64_t> & value, uint64_t n) {
+			value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+		}
+
+		std::atomic<uint64_t>	_nbFrames;
+		std::atomic<uint64_t>	_frameBuckets[METRICS_NB_BUCKETS + 1];  // not cumulative, last one is +Inf
+		std::atomic<uint64_t>	_frameUs;
+		std::atomic<uint64_t>	_nbLateFrames;  // longer than 1 / fps
+		std::atomic<uint64_t>	_nbOverBudget;  // longer than frameBudgetMs
+		std::atomic<uint64_t>	_nbDrawnFrames;  // the others were skipped (render-on-change)
+		std::atomic<uint64_t>	_nbMoves;
+		std::atomic<uint64_t>	_nbAIDecisions;
+		std::atomic<uint64_t>	_aiDecisionNs;
+		std::atomic<uint64_t>	_snakesAlive;
+		std::atomic<uint64_t>	_nbSpawns;
+		std::atomic<uint64_t>	_nbSpawnRetries;
+		std::atomic<uint64_t>	_nbSpawnFailures;
+		std::atomic<uint64_t>	_nbGuiSwitches;
+		std::atomic<uint64_t>	_guiSwitchUs;
+		std::atomic<uint64_t>	_soundUnderruns;
+		std::atomic<uint64_t>	_musicUnderruns;
+		std::atomic<uint64_t>	_soundDroppedCommands;
+
+		std::string				_socketPath;
+		std::thread				_thread;
+		int						_socketFd;
+		int						_stopPipe[2];
+
+		void	_serveLoop();
+		void	_serve(int clientFd);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace PerfCounter {
+	enum Enum {
+		CYCLES,
+		INSTRUCTIONS,
+		L1D_MISSES,
+		LLC_MISSES,
+		BRANCH_MISSES,
+		NB_COUNTERS,
+	};
+}
+
+namespace PerfPhase {
+	enum Enum {
+		INPUT,
+		MOVE,  // snakes & AI
+		FOOD_BONUS,
+		UPDATE,  // _update (single / multi player rules)
+		SOUND,
+		DRAW,
+		NB_PHASES,
+	};
+}
+
+/*
+	hardware counters of the game thread (linux perf_event_open), aggregated per phase of the game loop
+	the counters are opened as one group so the ratios (IPC, misses) stay valid when the kernel multiplexes them
+	a counter not supported by the cpu (or a VM) is skipped, the others still work
+*/
+class PerfCounters {
+	public:
+		struct Values {
+			uint64_t	counters[PerfCounter::NB_COUNTERS];
+			uint64_t	timeEnabled;
+			uint64_t	timeRunning;
+		};
+
+		PerfCounters();
+		virtual ~PerfCounters();
+		PerfCounters(PerfCounters const &src);
+		PerfCounters &operator=(PerfCounters const &rhs);
+
+		bool	start();  // open the counters on the current thread, false if perf is not available
+		void	stop();
+		bool	isEnabled() const { return _enabled; }
+
+		/* read the counters (zeros if disabled) */
+		Values	read() const;
+		/* add the counters since start to the phase, return the current values to chain the next phase */
+		Values	add(PerfPhase::Enum phase, Values const & start);
+		void	tick() { _nbTicks++; }
+		void	report() const;
+
+	private:
+		struct Phase {
+			uint64_t	nbCalls;
+			double		counters[PerfCounter::NB_COUNTERS];  // scaled if the counters were multiplexed
+		};
+
+		bool		_enabled;
+		int			_fds[PerfCounter::NB_COUNTERS];  // -1 if the counter is not available
+		int			_groupIdx[PerfCounter::NB_COUNTERS];  // position in the group read, -1 if not available
+		int			_nbOpened;
+		uint64_t	_nbTicks;
+		Phase		_phases[PerfPhase::NB_PHASES];
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#define PROFILE_INTERVAL_US 2000  // cpu time between two samples (500Hz, less if the kernel tick is slower)
+#define PROFILE_MAX_DEPTH 48  // frames kept per sample
+#define PROFILE_TABLE_SIZE 8192  // different stacks (power of 2), the next ones are dropped
+
+/*
+	sampling profiler: SIGPROF (setitimer) takes a backtrace of the running thread
+	the stacks are counted in a preallocated lock-free table: no allocation in the signal handler,
+	the memory used doesn't grow with the session length
+	on stop, the addresses are symbolized with dladdr (exported symbols, including the dlopen'd libraries
+	still loaded) and the ELF symbol table of each file (static & not exported functions)
+	then written as folded stacks (flamegraph.pl, speedscope, ...)
+*/
+class SampleProfiler {
+	public:
+		SampleProfiler();
+		virtual ~SampleProfiler();
+		SampleProfiler(SampleProfiler const &src);
+		SampleProfiler &operator=(SampleProfiler const &rhs);
+
+		bool	start(std::string const & filename);
+		/* stop sampling and write the folded stacks, call it before the libraries are closed */
+		bool	stop();
+		bool	isRunning() const { return _running; }
+
+	private:
+		struct Stack {
+			std::atomic<uint64_t>	hash;  // 0: free, 1: being written
+			std::atomic<uint64_t>	count;
+			uint32_t				depth;
+			void *					frames[PROFILE_MAX_DEPTH];  // leaf first
+		};
+
+		struct ElfSymbol {
+			uint64_t	start;
+			uint64_t	size;
+			std::string	name;
+		};
+		struct ElfFile {
+			bool					absolute;  // not PIE: the symbols are not relative to the load address
+			std::vector<ElfSymbol>	symbols;  // functions sorted by address
+		};
+		typedef std::map<std::string, ElfFile>	ElfCache;
+
+		std::string				_filename;
+		bool					_running;
+		Stack					_stacks[PROFILE_TABLE_SIZE];
+		std::atomic<uint64_t>	_nbSamples;
+		std::atomic<uint64_t>	_nbDropped;
+
+		void					_addSample(void ** frames, int depth);
+		static std::string		_symbolize(void * address, ElfCache & elfCache);
+		static std::string		_demangle(char const * name);
+		static void				_loadElfSymbols(std::string const & filename, ElfFile & elf);
+		static void				_signalHandler(int sig);
+};
+
+extern SampleProfiler	sampleProfiler;
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "nibbler.hpp"
+#include "SettingsJson.hpp"
+
+/*
+	watch the settings file (inotify) and reload it in a background thread
+	the new GameSettings are published with an atomic swap and applied by the game loop between two ticks
+	only the values in GameSettings are reloaded, the other settings need a restart
+*/
+class SettingsWatcher {
+	public:
+		SettingsWatcher();
+		virtual ~SettingsWatcher();
+		SettingsWatcher(SettingsWatcher const &src);
+		SettingsWatcher &operator=(SettingsWatcher const &rhs);
+
+		bool	start(std::string const & filename, SettingsJson const & settings);
+		void	stop();
+		/* game thread: replace settings if a reload is ready, never wait */
+		bool	update(GameSettings & settings);
+
+	private:
+		std::string					_filename;
+		SettingsJson				_base;  // settings before the reload (defaults & command line)
+		std::thread					_thread;
+		int							_inotifyFd;
+		int							_stopPipe[2];
+		std::atomic<GameSettings *>	_pending;  // last reloaded settings, not applied yet
+
+		void	_watchLoop(std::string const & dirname, std::string const & basename);
+		void	_reload();
+};
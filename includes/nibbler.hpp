@@ -5,10 +5,34 @@
 #endif
 #define DEBUG_FPS_LOW	DEBUG & false
 
+#define SETTINGS_FILE	"assets/settings.json"
+
 #include "SettingsJson.hpp"
 
+/*
+	settings read in the game loop, flattened from s once they are loaded
+	the loop read them directly instead of looking up s by name
+*/
+struct GameSettings {
+	uint64_t	fps;
+	uint64_t	speedMs;
+	uint64_t	maxSpeedMs;
+	int64_t		increasingSpeedStep;
+	uint64_t	snakeSize;
+	uint64_t	nbFood;
+	uint64_t	nbBonus;
+	int64_t		wallLife;
+	bool		pauseOnStart;
+	uint64_t	startSound;
+	uint64_t	aiChangeDirProba;
+	uint64_t	aiStrength;
+	uint64_t	frameBudgetMs;
+	bool		renderOnChange;
+};
+
 void						initLogs();
 bool						initSettings(std::string const & filename);
+GameSettings				loadGameSettings(SettingsJson const & settings);
 bool						initUserData(std::string const & filename);
 bool						saveUserData(std::string const & filename);
 bool						usage();
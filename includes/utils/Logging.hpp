@@ -5,6 +5,10 @@
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #define COLOR_EOC		"\x1B[0m"
 #define COLOR_RED		"\x1B[31m"
@@ -32,7 +36,24 @@ enum	eLoglevel {
 	LOGDEBUG, LOGINFO, LOGSUCCESS, LOGWARN, LOGERROR, LOGFATAL, NBLOG
 };
 
-#define log_(level, x) { std::stringstream ss; ss << x; logging.log(level, ss.str(), __FILE__, __LINE__); }
+#define LOG_QUEUE_SIZE 512  // logs waiting to be written (power of 2), logs are dropped if the queue is full
+#define LOG_MSG_SIZE 224  // longer messages are allocated
+
+// logs under LOG_MIN_LEVEL are removed at compilation (make DEFINE="LOG_MIN_LEVEL=3")
+#ifndef LOG_MIN_LEVEL
+	#if DEBUG
+		#define LOG_MIN_LEVEL 0  // LOGDEBUG
+	#else
+		#define LOG_MIN_LEVEL 1  // LOGINFO
+	#endif
+#endif
+
+// the message is only formatted if the level is enabled, the log is written by the logging thread
+#define log_(level, x) { \
+	if (static_cast<int>(level) >= LOG_MIN_LEVEL && level >= logging.getLoglevel()) { \
+		std::stringstream ss; ss << x; logging.log(level, ss.str(), __FILE__, __LINE__); \
+	} \
+}
 
 #define logDebug(x) log_(LOGDEBUG, x)
 #define logInfo(x) log_(LOGINFO, x)
@@ -56,15 +77,49 @@ class Logging {
 		void				setPrintFileLine(eLoglevel loglevel, bool printFileLine);
 		void				setPrintFileLine(bool printFileLine);
 
-		void				log(eLoglevel level, std::string message, std::string file = "", int line = -1);
+		/* file must be a string literal (__FILE__) */
+		void				log(eLoglevel level, std::string const & message, char const * file = "", int line = -1);
+		void				flush();  // wait until all the logs are written
 
 		std::string const &	getColor(eLoglevel loglevel) const;
 		eLoglevel			getLoglevel() const;
+		uint64_t			getNbDropped() const;
 
 	private:
+		struct Record {
+			eLoglevel		level;
+			char const *	file;
+			int				line;
+			bool			printFileLine;
+			uint32_t		size;
+			std::string *	longMessage;  // only if size >= LOG_MSG_SIZE
+			char			message[LOG_MSG_SIZE];
+		};
+		struct Slot {
+			std::atomic<uint64_t>	seq;  // == pos: free for the producer, == pos + 1: ready for the consumer
+			Record					record;
+		};
+
 		std::string		_colors[NBLOG];
 		bool			_printFileLine[NBLOG];
 		eLoglevel		_loglevel;
+
+		// multiple producers / single consumer lock-free queue
+		Slot					_slots[LOG_QUEUE_SIZE];
+		std::atomic<uint64_t>	_writePos;
+		std::atomic<uint64_t>	_readPos;
+		std::atomic<uint64_t>	_nbDropped;
+		std::atomic<bool>		_quit;
+		std::atomic<bool>		_sleeping;  // the logging thread is waiting on _cond
+		std::mutex				_mutex;  // only used to sleep
+		std::condition_variable	_cond;
+		std::thread				_thread;
+
+		void			_writeLoop();
+		bool			_writeNext();
+		void			_wake();
+		void			_write(std::ostream & out, eLoglevel level, bool printFileLine, char const * file, int line,
+			char const * message, uint32_t size) const;
 };
 
 extern Logging		logging;
@@ -23,16 +23,18 @@ class JsonObj {
 		explicit JsonObj(std::string const & name) { init(name); }
 		JsonObj(std::string const & name, T const & val) : _value(val) { init(name); }
 		virtual ~JsonObj() {}
-		JsonObj(JsonObj const & src) { *this = src; }
+		JsonObj(JsonObj const & src) { init(); *this = src; }
 		JsonObj & operator=(JsonObj const & rhs) {
 			if (this != &rhs) {
 				logDebug("WARNING -> JsonObj object copied");
 				_name = rhs._name;
+				_description = rhs._description;
 				_hasMin = rhs._hasMin;
 				_min = rhs._min;
 				_hasMax = rhs._hasMax;
 				_max = rhs._max;
 				_value = rhs._value;
+				_disableInFile = rhs._disableInFile;
 			}
 			return *this;
 		}
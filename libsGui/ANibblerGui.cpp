@@ -1,8 +1,13 @@
+#include <chrono>
+#include <thread>
 #include "ANibblerGui.hpp"
 
 ANibblerGui::ANibblerGui()
 : input(),
-  _gameInfo(nullptr) {}
+  _gameInfo(nullptr),
+  _tracer(nullptr),
+  _needRedraw(true),
+  _drawnVersion(0) {}
 
 ANibblerGui::~ANibblerGui() {
 }
@@ -20,6 +25,7 @@ ANibblerGui &ANibblerGui::operator=(ANibblerGui const &rhs) {
 
 bool ANibblerGui::init(GameInfo * gameInfo) {
 	_gameInfo = gameInfo;
+	_needRedraw = true;
 
 	input.paused = _gameInfo->paused;
 	input.direction.clear();
@@ -32,6 +38,51 @@ bool ANibblerGui::init(GameInfo * gameInfo) {
 	return _init();
 }
 
+/*
+called on the resident GUIs when switching GUI
+the activated GUI take the current game state in its input (as in init)
+*/
+void ANibblerGui::setActive(bool active) {
+	if (active && _gameInfo != nullptr) {
+		input.quit = false;
+		input.restart = false;
+		input.paused = _gameInfo->paused;
+		for (int id = 0; id < _gameInfo->nbPlayers; id++) {
+			input.direction[id] = _gameInfo->direction[id];
+			input.usingBonus[id] = false;
+		}
+	}
+	input.loadGuiID = NO_GUI_LOADED;
+	_needRedraw = true;  // the window content was hidden
+	_setActive(active);
+}
+
+/*
+render-on-change: draw only if the game state (GameInfo::stateVersion) or the view (_needRedraw) changed
+since the last draw, the window keep showing the last frame otherwise
+return true if the frame was drawn
+*/
+bool ANibblerGui::drawIfChanged() {
+	if (_needRedraw == false && _drawnVersion == _gameInfo->stateVersion)
+		return false;
+	_needRedraw = false;
+	_drawnVersion = _gameInfo->stateVersion;
+	draw();
+	return true;
+}
+
+/*
+wait until the next frame, the GUIs that can block on their event queue return as soon as an input arrive
+*/
+void ANibblerGui::waitInput(uint32_t timeoutUs) {
+	// sleep_for restarts after a signal (SIGPROF of the sample profiler), usleep doesn't
+	std::this_thread::sleep_for(std::chrono::microseconds(timeoutUs));
+}
+
+void ANibblerGui::_setActive(bool active) {
+	(void)active;
+}
+
 // -- GameInfo ------------------------------------------------------------------
 
 GameInfo::GameInfo(int nbPlayers_)
@@ -40,10 +91,11 @@ GameInfo::GameInfo(int nbPlayers_)
   height(600),
   boardSize(20),
   rules(),
-  nbPlayers(nbPlayers_) {
+  nbPlayers(nbPlayers_),
+  stateVersion(0) {
 	rules.canExitBorder = true;
 	for (int id = 0; id < nbPlayers; id++) {
-		snakes.push_back(std::deque<Vec2>());
+		snakes.push_back(PoolDeque<Vec2>());
 		nbBonus.push_back(0);
 		direction.push_back(Direction::MOVE_UP);
 		scores.push_back(0);
@@ -65,6 +117,49 @@ void GameInfo::restart() {
 	food.clear();
 	bonus.clear();
 	wall.clear();
+	stateVersion++;
+}
+
+// -- HudState ----------------------------------------------------------------
+
+HudState::HudState()
+: bestScore(0),
+  paused(false),
+  win(false),
+  gameOver(false),
+  winnerID(0),
+  valid(false) {}
+
+bool HudState::update(GameInfo const & gameInfo) {
+	bool changed = !valid;
+	if (scores.size() != static_cast<size_t>(gameInfo.nbPlayers)) {
+		scores.assign(gameInfo.nbPlayers, 0);
+		alive.assign(gameInfo.nbPlayers, false);
+		changed = true;
+	}
+	for (int id = 0; id < gameInfo.nbPlayers; id++) {
+		bool snakeAlive = gameInfo.snakes[id].size() > 0;
+		if (scores[id] != gameInfo.scores[id] || alive[id] != snakeAlive) {
+			scores[id] = gameInfo.scores[id];
+			alive[id] = snakeAlive;
+			changed = true;
+		}
+	}
+	if (bestScore != gameInfo.bestScore || paused != gameInfo.paused || win != gameInfo.win
+	|| gameOver != gameInfo.gameOver || winnerID != gameInfo.winnerID) {
+		bestScore = gameInfo.bestScore;
+		paused = gameInfo.paused;
+		win = gameInfo.win;
+		gameOver = gameInfo.gameOver;
+		winnerID = gameInfo.winnerID;
+		changed = true;
+	}
+	valid = true;
+	return changed;
+}
+
+void HudState::invalidate() {
+	valid = false;
 }
 
 // -- Vec2 ---------------------------------------------------------------------
@@ -97,6 +192,7 @@ void ANibblerGui::Input::reset() {
 	quit = false;
 	paused = false;
 	restart = false;
+	saveTrace = false;
 	for (int id = 0; id < static_cast<int>(direction.size()); id++) {
 		Direction::Enum dir = (id & 1) ? Direction::MOVE_UP : Direction::MOVE_DOWN;
 		direction[id] = dir;
@@ -7,6 +7,8 @@
 #include <deque>
 #include <vector>
 
+#include "PoolAllocator.hpp"
+
 #define SNAKE_1_COLOR_1 0x024fd6  // #024fd6
 #define SNAKE_1_COLOR_2 0x4C90FF  // #4C90FF
 #define SNAKE_2_COLOR_1 0x02d64f  // #02d64f
@@ -38,6 +40,8 @@
 
 #define HEIGHT_RATIO	0.7  // ratio of height from width
 
+class Tracer;
+
 namespace Direction {
 	enum Enum {
 		MOVE_UP = 0,
@@ -47,7 +51,7 @@ namespace Direction {
 	};
 }
 
-struct Vec2 {  // the Vec2 is a std::deque of struct Vec2
+struct Vec2 {  // the snakes are a PoolDeque of struct Vec2
 	int	x;
 	int	y;
 
@@ -58,19 +62,20 @@ struct Vec2 {  // the Vec2 is a std::deque of struct Vec2
 
 struct GameInfo {
 	// snake informations
-	std::vector<std::deque<Vec2>>	snakes;
+	// PoolDeque: the chunks are recycled, a game tick don't allocate
+	std::vector<PoolDeque<Vec2>>	snakes;
 	std::vector<Direction::Enum>	direction;
 	std::vector<uint32_t>			scores;
 	std::vector<bool>				isIA;
 	std::vector<uint16_t>			nbBonus;
 
-	std::deque<Vec2>				food;
-	std::deque<Vec2>				bonus;
+	PoolDeque<Vec2>					food;
+	PoolDeque<Vec2>					bonus;
 	struct Wall {
 		Vec2	pos;
 		int		life;
 	};
-	std::deque<Wall>				wall;
+	PoolDeque<Wall>					wall;
 	std::string	title;
 	uint16_t	realWidth;
 	uint16_t	realHeight;
@@ -91,6 +96,7 @@ struct GameInfo {
 	uint32_t	bestScore;
 	int			nbPlayers;
 	int			winnerID;
+	uint64_t	stateVersion;  // incremented by the game each time something shown change (render-on-change)
 
 	std::string	font;
 
@@ -98,6 +104,26 @@ struct GameInfo {
 	void restart();
 };
 
+/*
+HudState keep the values shown in the HUD (scores, best score, game state)
+update return true only if one of them changed since the last call
+-> the GUIs re-layout their texts only in this case
+*/
+struct HudState {
+	std::vector<uint32_t>	scores;
+	std::vector<bool>		alive;
+	uint32_t				bestScore;
+	bool					paused;
+	bool					win;
+	bool					gameOver;
+	int						winnerID;
+	bool					valid;  // false until the first update
+
+	HudState();
+	bool	update(GameInfo const & gameInfo);
+	void	invalidate();
+};
+
 class ANibblerGui {
 	public:
 		ANibblerGui();
@@ -106,8 +132,12 @@ class ANibblerGui {
 		ANibblerGui &operator=(ANibblerGui const &rhs);
 
 		virtual	bool	init(GameInfo *gameInfo);
+		void			setActive(bool active);  // show / hide a resident GUI (DynManager resident mode)
+		void			setTracer(Tracer * tracer) { _tracer = tracer; }
 		virtual void	updateInput() = 0;
 		virtual	bool	draw() = 0;
+		bool			drawIfChanged();
+		virtual void	waitInput(uint32_t timeoutUs);
 
 		struct Input {
 			bool							quit;
@@ -116,6 +146,7 @@ class ANibblerGui {
 			std::vector<Direction::Enum>	direction;
 			std::vector<bool>				usingBonus;
 			uint8_t							loadGuiID;
+			bool							saveTrace;
 
 			Input();
 			Input(Input const &src);
@@ -128,8 +159,12 @@ class ANibblerGui {
 
 	protected:
 		GameInfo *_gameInfo;
+		Tracer *	_tracer;  // owned by the game, null if not set
+		bool		_needRedraw;  // the view changed (camera, window...), draw even if the game state didn't
+		uint64_t	_drawnVersion;  // GameInfo::stateVersion of the last draw
 
 		virtual	bool	_init() = 0;
+		virtual void	_setActive(bool active);
 };
 
 uint32_t mixColor(uint32_t c1, uint32_t c2, float factor);
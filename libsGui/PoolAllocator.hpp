@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <deque>
+#include <new>
+
+#define POOL_MAX_FREE_BLOCKS 64  // blocks kept per thread & type, the next ones are freed
+
+/*
+	allocator that keeps the freed blocks of one size in a per-thread free list
+	a std::deque used as a queue (snake: push_front & pop_back) allocates a chunk each time the head
+	leaves the current chunk and frees one at the tail: with this allocator the same chunks are recycled,
+	so moving the snakes don't allocate anymore once the game is running
+	the first deallocated size is pooled (the chunk size of the deque), the other sizes use operator new
+	stateless: a block can be freed by any allocator of the same type (it goes in the list of the current thread)
+*/
+template<typename T>
+class PoolAllocator {
+	public:
+		typedef T	value_type;
+
+		PoolAllocator() {}
+		template<typename U>
+		explicit PoolAllocator(PoolAllocator<U> const &) {}  // rebind (the deque map)
+
+		T *		allocate(size_t n) {
+			FreeList & list = _freeList();
+			if (n == list.blockSize && list.head != nullptr) {
+				Block * block = list.head;
+				list.head = block->next;
+				list.nbBlocks--;
+				return reinterpret_cast<T *>(block);
+			}
+			return static_cast<T *>(::operator new(n * sizeof(T)));
+		}
+		void	deallocate(T * ptr, size_t n) {
+			FreeList & list = _freeList();
+			if (list.blockSize == 0 && n * sizeof(T) >= sizeof(Block))
+				list.blockSize = n;
+			if (n == list.blockSize && list.nbBlocks < POOL_MAX_FREE_BLOCKS) {
+				Block * block = reinterpret_cast<Block *>(ptr);
+				block->next = list.head;
+				list.head = block;
+				list.nbBlocks++;
+				return;
+			}
+			::operator delete(ptr);
+		}
+
+	private:
+		struct Block {
+			Block *	next;
+		};
+		// trivial (no destructor): a library can be closed before its threads end
+		struct FreeList {
+			Block *	head;
+			size_t	blockSize;  // in T, 0 until the first deallocation
+			size_t	nbBlocks;
+		};
+
+		static FreeList &	_freeList() {
+			static thread_local FreeList	list = {nullptr, 0, 0};
+			return list;
+		}
+};
+
+template<typename T, typename U>
+bool	operator==(PoolAllocator<T> const &, PoolAllocator<U> const &) { return true; }
+template<typename T, typename U>
+bool	operator!=(PoolAllocator<T> const &, PoolAllocator<U> const &) { return false; }
+
+template<typename T>
+using PoolDeque = std::deque<T, PoolAllocator<T>>;
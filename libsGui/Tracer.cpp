@@ -0,0 +1,226 @@
+#include <unistd.h>
+#ifdef __linux__
+	#include <sys/syscall.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "Tracer.hpp"
+#include "Logging.hpp"
+
+Tracer::Tracer()
+: _enabled(false),
+  _startNs(nowNs()),
+  _mutex(),
+  _buffers() {}
+
+Tracer::~Tracer() {
+	for (ThreadBuffer * buffer : _buffers)
+		delete buffer;
+}
+
+Tracer::Tracer(Tracer const &src)
+: Tracer() {
+	*this = src;
+}
+
+Tracer &Tracer::operator=(Tracer const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use Tracer copy operator");
+	}
+	return *this;
+}
+
+void	Tracer::setEnabled(bool enabled) {
+	_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t	Tracer::end(char const * name, uint64_t startNs, int32_t arg) {
+	if (!isEnabled())
+		return 0;
+	uint64_t now = nowNs();
+	if (startNs == 0)  // enabled during the span
+		return now;
+	add(name, startNs, now, arg);
+	return now;
+}
+
+void	Tracer::add(char const * name, uint64_t startNs, uint64_t endNs, int32_t arg) {
+	if (!isEnabled())
+		return;
+	ThreadBuffer * buffer = _getBuffer();
+	Span & span = buffer->spans[buffer->writePos & (TRACE_BUFFER_SIZE - 1)];
+	std::strncpy(span.name, name, TRACE_NAME_SIZE - 1);
+	span.name[TRACE_NAME_SIZE - 1] = '\0';
+	span.arg = arg;
+	span.startNs = startNs;
+	span.durationNs = endNs - startNs;
+	buffer->writePos++;
+}
+
+/*
+	write all the spans as "complete" events (ph: X), times are in us from the start of the tracer
+*/
+bool	Tracer::save(std::string const & filename) {
+	std::ofstream	file(filename);
+	if (!file.is_open()) {
+		logErr("unable to save trace in " << filename);
+		return false;
+	}
+
+	std::lock_guard<std::mutex>	lock(_mutex);
+	uint64_t	nbSpans = 0;
+	pid_t		pid = getpid();
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (ThreadBuffer const * buffer : _buffers) {
+		uint64_t end = buffer->writePos;
+		uint64_t begin = (end > TRACE_BUFFER_SIZE) ? end - TRACE_BUFFER_SIZE : 0;
+		for (uint64_t i = begin; i < end; i++) {
+			Span const & span = buffer->spans[i & (TRACE_BUFFER_SIZE - 1)];
+			file << (nbSpans == 0 ? "\n" : ",\n");
+			file << "{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+				<< ",\"ts\":" << (span.startNs > _startNs ? span.startNs - _startNs : 0) / 1000.0
+				<< ",\"dur\":" << span.durationNs / 1000.0;
+			if (span.arg >= 0)
+				file << ",\"args\":{\"id\":" << span.arg << "}";
+			file << "}";
+			nbSpans++;
+		}
+	}
+	file << "\n]}\n";
+	file.close();
+	if (file.fail()) {
+		logErr("unable to save trace in " << filename);
+		return false;
+	}
+	logInfo("trace saved in " << filename << " (" << nbSpans << " spans)");
+	return true;
+}
+
+/*
+	spans sorted by start time, a span inside the previous one of the same thread is indented
+	the other threads are shown with their tid (work done in parallel)
+*/
+void	Tracer::logSpans(std::string const & title, uint64_t endNs) {
+	struct Entry {
+		Span const *	span;
+		uint64_t		tid;
+	};
+	uint64_t			mainTid = _getBuffer()->tid;  // the caller is the main thread (before the lock)
+	std::vector<Entry>	entries;
+	std::lock_guard<std::mutex>	lock(_mutex);
+	for (ThreadBuffer const * buffer : _buffers) {
+		uint64_t end = buffer->writePos;
+		uint64_t begin = (end > TRACE_BUFFER_SIZE) ? end - TRACE_BUFFER_SIZE : 0;
+		for (uint64_t i = begin; i < end; i++) {
+			Span const & span = buffer->spans[i & (TRACE_BUFFER_SIZE - 1)];
+			if (span.startNs >= _startNs && span.startNs + span.durationNs <= endNs)
+				entries.push_back({&span, buffer->tid});
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](Entry const & a, Entry const & b) {
+		if (a.span->startNs != b.span->startNs)
+			return a.span->startNs < b.span->startNs;
+		return a.span->durationNs > b.span->durationNs;  // the parent first
+	});
+
+	std::stringstream	out;  // not ss: name used by the log macros
+	out << std::fixed << std::setprecision(2);
+	out << title << " (" << (endNs - _startNs) / 1000000.0 << "ms):\n";
+	out << std::setw(10) << "start" << std::setw(11) << "duration" << std::setw(9) << "thread" << "  phase";
+	std::vector<std::pair<uint64_t, uint64_t>>	open;  // tid & end of the spans containing the current one
+	for (Entry const & entry : entries) {
+		uint64_t	start = entry.span->startNs;
+		int			depth = 0;
+		for (auto it = open.begin(); it != open.end();) {
+			if (it->second <= start) {
+				it = open.erase(it);
+				continue;
+			}
+			if (it->first == entry.tid)
+				depth++;
+			++it;
+		}
+		open.push_back({entry.tid, start + entry.span->durationNs});
+		out << "\n" << std::setw(8) << (start - _startNs) / 1000000.0 << "ms"
+			<< std::setw(9) << entry.span->durationNs / 1000000.0 << "ms"
+			<< std::setw(9);
+		if (entry.tid == mainTid)
+			out << "main";
+		else
+			out << entry.tid;
+		out << "  " << std::string(depth * 2, ' ') << entry.span->name;
+		if (entry.span->arg >= 0)
+			out << " (" << entry.span->arg << ")";
+	}
+	logInfo(out.str());
+}
+
+uint64_t	Tracer::nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// -- private -----------------------------------------------------------------
+
+/*
+	the buffer of the current thread, shared by the game & the GUI libraries (each one has its own thread_local cache)
+*/
+Tracer::ThreadBuffer *	Tracer::_getBuffer() {
+	static thread_local ThreadBuffer *	buffer = nullptr;
+	static thread_local Tracer *		owner = nullptr;
+	if (buffer != nullptr && owner == this)
+		return buffer;
+
+	#ifdef __linux__
+		uint64_t tid = syscall(SYS_gettid);
+	#else
+		uint64_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+	#endif
+	std::lock_guard<std::mutex>	lock(_mutex);
+	buffer = nullptr;
+	for (ThreadBuffer * threadBuffer : _buffers) {
+		if (threadBuffer->tid == tid)
+			buffer = threadBuffer;
+	}
+	if (buffer == nullptr) {
+		buffer = new ThreadBuffer();
+		buffer->tid = tid;
+		buffer->writePos = 0;
+		_buffers.push_back(buffer);
+	}
+	owner = this;
+	return buffer;
+}
+
+// -- TraceScope ---------------------------------------------------------------
+
+TraceScope::TraceScope(Tracer * tracer, char const * name, int32_t arg)
+: _tracer(tracer),
+  _name(name),
+  _arg(arg),
+  _startNs((tracer != nullptr) ? tracer->begin() : 0) {}
+
+TraceScope::~TraceScope() {
+	if (_tracer != nullptr && _startNs != 0)
+		_tracer->end(_name, _startNs, _arg);
+}
+
+TraceScope::TraceScope(TraceScope const &src)
+: _tracer(nullptr),
+  _name(nullptr),
+  _arg(-1),
+  _startNs(0) {
+	*this = src;
+}
+
+TraceScope &TraceScope::operator=(TraceScope const &rhs) {
+	(void)rhs;
+	return *this;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define TRACE_BUFFER_SIZE (1 << 14)  // spans kept per thread (power of 2), the oldest are overwritten
+#define TRACE_NAME_SIZE 32  // names are copied: a GUI library can be closed before the trace is saved
+
+// TRACE_SCOPE(tracer, name[, arg]) -> span from here to the end of the scope
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(tracer, ...) TraceScope TRACE_CONCAT(traceScope, __LINE__)(tracer, __VA_ARGS__)
+
+/*
+	record spans in per-thread buffers and save them as chrome trace_event json (chrome://tracing, ui.perfetto.dev)
+	the game owns the tracer and gives a pointer to the GUIs & DynManager: the libraries spans are on the same timeline
+	when disabled, a span costs one atomic load
+*/
+class Tracer {
+	public:
+		Tracer();
+		virtual ~Tracer();
+		Tracer(Tracer const &src);
+		Tracer &operator=(Tracer const &rhs);
+
+		void			setEnabled(bool enabled);
+		bool			isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+		/* begin/end for the sequential phases: end return the current time to chain the next phase */
+		uint64_t		begin() const { return isEnabled() ? nowNs() : 0; }
+		uint64_t		end(char const * name, uint64_t startNs, int32_t arg = -1);
+		/* span measured before the tracer was enabled (or on another clock start) */
+		void			add(char const * name, uint64_t startNs, uint64_t endNs, int32_t arg = -1);
+		bool			save(std::string const & filename);
+		/* log the spans between the tracer start and endNs, indented by nesting (startup breakdown) */
+		void			logSpans(std::string const & title, uint64_t endNs);
+
+		/* time 0 of the trace (default: tracer construction) */
+		void			setStartNs(uint64_t startNs) { _startNs = startNs; }
+		uint64_t		getStartNs() const { return _startNs; }
+
+		static uint64_t	nowNs();
+
+	private:
+		struct Span {
+			char		name[TRACE_NAME_SIZE];
+			int32_t		arg;  // -1 for no arg
+			uint64_t	startNs;
+			uint64_t	durationNs;
+		};
+		struct ThreadBuffer {
+			uint64_t	tid;
+			uint64_t	writePos;  // written by its thread only
+			Span		spans[TRACE_BUFFER_SIZE];
+		};
+
+		std::atomic<bool>			_enabled;
+		uint64_t					_startNs;  // the timestamps are saved from this time
+		std::mutex					_mutex;  // protect _buffers (locked on the first span of a thread)
+		std::vector<ThreadBuffer *>	_buffers;
+
+		ThreadBuffer *	_getBuffer();
+};
+
+/*
+	span on the current scope, nothing is recorded if tracer is null or disabled
+*/
+class TraceScope {
+	public:
+		TraceScope(Tracer * tracer, char const * name, int32_t arg = -1);
+		virtual ~TraceScope();
+
+	private:
+		TraceScope(TraceScope const &src);
+		TraceScope &operator=(TraceScope const &rhs);
+
+		Tracer *		_tracer;
+		char const *	_name;
+		int32_t			_arg;
+		uint64_t		_startNs;
+};
@@ -8,13 +8,59 @@
 #include "Camera.hpp"
 #include "TextRender.hpp"
 #include "Skybox.hpp"
+#include "UniformBuffer.hpp"
+#include "PassTimer.hpp"
 
 #define CUBE_VS_PATH "libsGui/nibblerOpenGL/shaders/cube_vs.glsl"
 #define CUBE_FS_PATH "libsGui/nibblerOpenGL/shaders/cube_fs.glsl"
+#define BOARD_VS_PATH "libsGui/nibblerOpenGL/shaders/board_vs.glsl"
+#define BOARD_FS_PATH "libsGui/nibblerOpenGL/shaders/board_fs.glsl"
+
+#define BOARD_TEXTURE_MIN_SIZE 40  // from this boardSize, the board is drawn from a texture instead of cubes
+#define BOARD_CHUNK_SIZE 8  // size (in cells) of the board tiles used for frustum culling
 
 #define TO_OPENGL_COLOR(color) glm::vec4(GET_R(color) / 255.0, GET_G(color) / 255.0, GET_B(color) / 255.0, 1.0)
 
 #define SIZE_LINE 6
+#define NB_CUBE_VERTICES 36
+
+/* per instance data of a cube (location 2 & 3 in cube_vs.glsl) */
+struct CubeInstance {
+	glm::vec3	pos;
+	glm::vec4	color;
+};
+
+/* a tile of the board, tested once per frame against the camera frustum */
+struct BoardChunk {
+	glm::vec3	start;  // min corner of the bounding box
+	glm::vec3	size;
+	uint32_t	firstInstance;  // first instance of the chunk in _boardInstanceVBO
+	uint32_t	nbInstances;
+};
+
+/* type of a cell in the board texture (texel value, see board_fs.glsl) */
+namespace BoardCell {
+	enum Enum {
+		EMPTY = 0,
+		WALL = 1,
+		FOOD = 2,
+		BONUS = 3,
+		SNAKE_BONUS = 4,
+		SNAKE = 5,  // SNAKE + (id % 6)
+		NB_TYPES = SNAKE + 6,
+	};
+}
+
+/* render passes timed by PassTimer */
+namespace RenderPass {
+	enum Enum {
+		BOARD = 0,
+		SNAKES = 1,  // snakes, wall, food & bonus
+		SKYBOX = 2,
+		TEXT = 3,
+		NB_PASSES = 4,
+	};
+}
 
 class NibblerOpenGL : public ANibblerGui {
 	public:
@@ -25,6 +71,7 @@ class NibblerOpenGL : public ANibblerGui {
 
 		virtual void	updateInput();
 		virtual bool	draw();
+		virtual void	waitInput(uint32_t timeoutUs);
 
 	private:
 		SDL_Window *	_win;
@@ -37,11 +84,55 @@ class NibblerOpenGL : public ANibblerGui {
 		Skybox *			_skybox;
 		int					_textBasicHeight;
 		int					_textTitleHeight;
-		uint32_t			_cubeShaderVAO;
-		uint32_t			_cubeShaderVBO;
+		uint32_t			_cubeShaderVAO;  // cube mesh + board instances
+		uint32_t			_cubeShaderVBO;  // cube mesh
+		uint32_t			_boardInstanceVBO;
+		uint32_t			_nbBoardInstances;
+		uint8_t				_boardInstancesSize;  // boardSize used to build _boardInstanceVBO
+		uint32_t			_entitiesVAO;  // cube mesh + entities instances
+		uint32_t			_entitiesInstanceVBO;
+		std::vector<CubeInstance>	_entitiesInstances;  // snakes, wall, food & bonus, rebuilt each frame
+		std::vector<BoardChunk>	_boardChunks;  // board tiles, row by row
+		std::vector<bool>		_visibleChunks;  // result of the frustum culling for each chunk (this frame)
+		uint32_t				_nbVisibleChunks;
+		uint32_t				_nbChunksX;  // number of chunks in a row
+		uint8_t					_boardChunksSize;  // boardSize used to build _boardChunks
+		Shader *			_boardShader;
+		uint32_t			_boardTexture;  // R8 texture, one texel per cell (BoardCell::Enum)
+		uint8_t				_boardTextureSize;  // boardSize used to create _boardTexture
+		uint32_t			_boardQuadVAO;
+		uint32_t			_boardQuadVBO;
+		std::vector<uint8_t>	_boardCells;  // cpu copy of _boardTexture
+		std::vector<uint8_t>	_nextCells;  // cells painted this frame, EMPTY everywhere else
+		std::vector<uint32_t>	_paintedCells;  // index of the cells painted last frame
+		std::vector<uint32_t>	_frameCells;  // index of the cells painted this frame
+		std::vector<uint32_t>	_dirtyCells;  // index of the cells to upload
 		static const float	_cubeVertices[];
 		glm::mat4			_projection;
+		UniformBuffer *		_perFrameUbo;  // PerFrame block shared by all shaders
+		PerFrameUbo			_perFrame;  // cpu copy of _perFrameUbo, uploaded once per frame
 		uint64_t			_lastLoopMs;
+		PassTimer *			_passTimer;  // CPU & GPU time of each RenderPass
+		bool				_showPassTimes;  // overlay with the time of each pass (F3)
+		HudState						_hudState;  // values shown in _hudTexts
+		std::vector<TextRender::Text>	_hudTexts;  // HUD texts, re-layout only if _hudState change
+		size_t							_nbHudTexts;  // number of _hudTexts used
 
 		virtual bool	_init();
+		virtual void	_setActive(bool active);
+		void			_initCubeVAO(uint32_t vao, uint32_t instanceVBO);
+		void			_setInstanceOffset(uint32_t instanceVBO, uint32_t firstInstance);
+		void			_buildBoardChunks();
+		void			_updateVisibleChunks();
+		bool			_isCellVisible(int x, int y) const;
+		void			_drawBoardCubes();
+		void			_buildBoardInstances();
+		void			_drawBoardTexture();
+		void			_initBoardTexture();
+		void			_paintCell(int x, int y, uint8_t type);
+		void			_addCubeInstance(std::vector<CubeInstance> &instances, int x, int y, int z, uint32_t color);
+		void			_buildHud();
+		void			_drawPassTimes();
+		void			_addHudText(std::string const &fontName, std::string const &str, float x, float y,
+			uint32_t color);
 };
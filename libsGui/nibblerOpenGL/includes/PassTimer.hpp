@@ -0,0 +1,58 @@
+#ifndef PASSTIMER_HPP_
+#define PASSTIMER_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "commonInclude.hpp"
+
+#define PASS_TIMER_RING_SIZE	4  // frames in flight before a query is read back
+#define PASS_TIMER_SMOOTHING	0.05  // weight of the last frame in the smoothed values (overlay)
+
+/*
+	PassTimer measure the CPU & GPU time of each render pass
+	GPU time use GL_TIME_ELAPSED queries, stored in a ring of PASS_TIMER_RING_SIZE frames:
+	the result of a frame is read PASS_TIMER_RING_SIZE frames later (only if available)
+	-> the CPU never wait for the GPU
+	passes must not be nested (only one GL_TIME_ELAPSED query can be active)
+*/
+class PassTimer {
+	public:
+		explicit PassTimer(std::vector<std::string> const &passNames);
+		PassTimer(PassTimer const &src);
+		virtual ~PassTimer();
+
+		PassTimer &operator=(PassTimer const &rhs);
+
+		void	begin(uint32_t pass);
+		void	end(uint32_t pass);
+		void	endFrame();  // call it once per frame, after the last pass
+
+		struct PassStats {
+			std::string	name;
+			double		cpuMs;  // smoothed
+			double		gpuMs;  // smoothed
+			double		totalCpuMs;
+			double		totalGpuMs;
+			double		maxCpuMs;
+			double		maxGpuMs;
+			uint64_t	nbCpu;
+			uint64_t	nbGpu;
+
+			PassStats();
+		};
+		std::vector<PassStats> const	&getStats() const;
+		std::string						getReport() const;
+
+	private:
+		PassTimer();
+		void	_readQueries(uint32_t frame);
+
+		std::vector<PassStats>	_stats;
+		std::vector<GLuint>		_queries;  // [frame * nbPasses + pass]
+		std::vector<bool>		_issued;  // the query was used in this frame
+		std::vector<std::chrono::high_resolution_clock::time_point>	_cpuStart;
+		uint32_t				_frame;  // current frame in the ring
+};
+
+#endif  // PASSTIMER_HPP_
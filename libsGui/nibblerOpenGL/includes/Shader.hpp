@@ -4,12 +4,20 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 
 #include "commonInclude.hpp"
 
+#define SHADER_CACHE_DIR	".shaderCache"  // linked programs (glGetProgramBinary) are saved here
+#define SHADER_CACHE_MAGIC	0x4E425042  // "NBPB", first bytes of a cache file
+
 /*
 	Shader class used to manage shader compilation
 	It also adds some tools to set uniform and activate shader easier
+	All uniforms locations are resolved after linking, use getUniform to get a typed handle
+	and set(handle, value) in the hot loop (no string lookup)
+	Linked programs are cached in SHADER_CACHE_DIR, keyed by a hash of the sources and the driver,
+	the next loads skip the compilation (fallback to the sources if the cache is invalid)
 
 	Warning! before instantiating a Shader object you need to create the opengl contex
 	with glfwCreateWindow
@@ -22,8 +30,31 @@ class Shader {
 
 		Shader &operator=(Shader const &rhs);
 
+		/* typed handle on an uniform location (-1 if the uniform doesn't exist) */
+		template<class T>
+		struct Uniform {
+			GLint	location;
+
+			Uniform() : location(-1) {}
+			explicit Uniform(GLint location_) : location(location_) {}
+		};
+
+		template<class T>
+		Uniform<T>	getUniform(std::string const &name) const { return Uniform<T>(getUniformLocation(name)); }
+		GLint		getUniformLocation(std::string const &name) const;
+		bool		bindUniformBlock(std::string const &blockName, GLuint bindingPoint);
+
 		void	use();
 		void	unuse();
+		void	set(Uniform<bool> const &uniform, bool value) const;
+		void	set(Uniform<int> const &uniform, int value) const;
+		void	set(Uniform<float> const &uniform, float value) const;
+		void	set(Uniform<glm::vec2> const &uniform, const glm::vec2 &vec) const;
+		void	set(Uniform<glm::vec3> const &uniform, const glm::vec3 &vec) const;
+		void	set(Uniform<glm::vec4> const &uniform, const glm::vec4 &vec) const;
+		void	set(Uniform<glm::mat3> const &uniform, const glm::mat3 &mat) const;
+		void	set(Uniform<glm::mat4> const &uniform, const glm::mat4 &mat) const;
+
 		void	setBool(const std::string &name, bool value) const;
 		void	setInt(const std::string &name, int value) const;
 		void	setFloat(const std::string &name, float value) const;
@@ -71,7 +102,12 @@ class Shader {
 		uint32_t	id;
 
 	private:
+		std::unordered_map<std::string, GLint>	_uniforms;  // uniforms locations, filled after linking
+
 		void	checkCompileErrors(uint32_t shader, std::string type);
+		void	_loadUniforms();
+		bool	_loadBinary(std::string const &cacheFile);
+		void	_saveBinary(std::string const &cacheFile);
 };
 
 #endif  // SHADER_HPP_
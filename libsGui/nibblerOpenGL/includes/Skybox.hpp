@@ -1,9 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <future>
+#include <memory>
 
 #include "commonInclude.hpp"
 #include "Shader.hpp"
+#include "UniformBuffer.hpp"
 
 #define SHADER_SKYBOX_VS "libsGui/nibblerOpenGL/shaders/skybox_vs.glsl"
 #define SHADER_SKYBOX_FS "libsGui/nibblerOpenGL/shaders/skybox_fs.glsl"
@@ -48,13 +51,30 @@
 
 class Skybox {
 	public:
+		/* a decoded face, decodeFace doesn't use OpenGL -> it can run on a worker thread */
+		struct Image {
+			std::string	path;
+			int			width;
+			int			height;
+			int			nrChannels;
+			std::unique_ptr<unsigned char, void (*)(void *)>	data;  // freed with stbi_image_free
+
+			Image();
+		};
+
 		Skybox();
+		explicit Skybox(std::vector<std::future<Image> > &faces);
 		Skybox(Skybox const &src);
 		virtual ~Skybox();
 
 		Skybox &operator=(Skybox const &rhs);
 
+		static std::vector<std::string>				getDefaultFaces();
+		static Image								decodeFace(std::string const &path);
+		static std::vector<std::future<Image> >	decodeFacesAsync(std::vector<std::string> const &faces);
+
 		void load(std::vector<std::string> &faces);
+		void load(std::vector<std::future<Image> > &faces);
 		void draw(float nightProgress = 0);
 
 		Shader			&getShader();
@@ -62,7 +82,10 @@ class Skybox {
 		uint32_t		getTextureID() const;
 	protected:
 	private:
+		void	_init(std::vector<std::future<Image> > &faces);
+
 		Shader		_shader;
+		Shader::Uniform<float>	_nightProgressUniform;
 		uint32_t	_textureID;
 		uint32_t	_vao;
 		uint32_t	_vbo;
@@ -4,12 +4,17 @@
 #include FT_FREETYPE_H
 #include <stdexcept>
 #include <map>
+#include <vector>
 #include "commonInclude.hpp"
 #include "Shader.hpp"
+#include "UniformBuffer.hpp"
 
 #define SHADER_TEXT_VS "libsGui/nibblerOpenGL/shaders/text_vs.glsl"
 #define SHADER_TEXT_FS "libsGui/nibblerOpenGL/shaders/text_fs.glsl"
 #define SHADER_TEXT_ROW_SIZE 4
+#define TEXT_NB_CHARS 128  // only ascii chars are loaded
+#define TEXT_ATLAS_WIDTH 1024  // width of the atlas texture, height depends on the font size
+#define TEXT_ATLAS_PADDING 1  // space between glyphs in the atlas (avoid bleeding with GL_LINEAR)
 
 class TextRender {
 	public:
@@ -18,14 +23,37 @@ class TextRender {
 		virtual ~TextRender();
 
 		TextRender &operator=(TextRender const &rhs);
+		struct GlyphSet;
 		void loadFont(std::string name, std::string const &filename, uint32_t size);
+		void loadFont(std::string name, GlyphSet const &glyphs);
+		static GlyphSet	rasterizeFont(std::string const &filename, uint32_t size);
 		void write(std::string const &fontName, std::string text, GLfloat x = 0, GLfloat y = 0, GLfloat scale = 1,
 			glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f));
 		uint32_t	strWidth(std::string const &fontName, std::string text, GLfloat scale = 1);
 
+		/*
+		Text keep the geometry of a string on the GPU
+		build it with setText only when the string change and draw it each frame with draw
+		*/
+		struct Text {
+			GLuint		vao;
+			GLuint		vbo;
+			GLuint		texture;  // atlas of the font
+			GLsizei		nbVertices;
+			glm::vec3	color;
+			uint32_t	width;
+
+			Text();
+		};
+		void		setText(Text &text, std::string const &fontName, std::string const &str, GLfloat x = 0,
+			GLfloat y = 0, GLfloat scale = 1, glm::vec3 color = glm::vec3(1.0f, 1.0f, 1.0f));
+		void		draw(Text const &text);
+		void		deleteText(Text &text);
+
 
 		Shader			&getShader();
 		Shader const	&getShader() const;
+		glm::mat4 const	&getProjection() const;  // set it in PerFrameUbo::textProjection
 
 		class TextRenderError : public std::exception {
 			public:
@@ -38,17 +66,40 @@ class TextRender {
 				}
 		};
 		struct Character {
-			GLuint		textureID;
 			glm::ivec2	size;
 			glm::ivec2	bearing;
 			int64_t		advance;
+			glm::vec2	uvMin;  // top left of the glyph in the atlas
+			glm::vec2	uvMax;  // bottom right of the glyph in the atlas
+		};
+		/*
+		all glyphs of a font are packed in one atlas texture
+		chars is indexed by the char code
+		*/
+		struct Font {
+			GLuint		textureID;
+			Character	chars[TEXT_NB_CHARS];
+
+			Font();
+		};
+		std::map<std::string, Font> font;
+
+		/* a font rasterized on the cpu (rasterizeFont), ready to be uploaded with loadFont */
+		struct GlyphSet {
+			Font					font;  // metrics & uv of each char (textureID is set on upload)
+			uint32_t				atlasHeight;
+			std::vector<uint8_t>	atlas;  // TEXT_ATLAS_WIDTH * atlasHeight, one byte per pixel
+
+			GlyphSet();
 		};
-		std::map<std::string, std::map<GLchar, Character> > font;
 
 	private:
 		TextRender();
+		uint32_t	_buildVertices(Font const &f, std::string const &str, GLfloat x, GLfloat y, GLfloat scale,
+			std::vector<GLfloat> &vertices) const;
 
 		Shader		_shader;
+		Shader::Uniform<glm::vec3>	_textColorUniform;
 		glm::mat4	_projection;
 		GLuint		_vao;
 		GLuint		_vbo;
@@ -0,0 +1,51 @@
+#ifndef UNIFORMBUFFER_HPP_
+#define UNIFORMBUFFER_HPP_
+
+#include "commonInclude.hpp"
+
+/* per frame data shared by all shaders (uniform block PerFrame) */
+#define PER_FRAME_UBO_NAME		"PerFrame"
+#define PER_FRAME_UBO_BINDING	0
+
+/*
+	mirror of the PerFrame uniform block (std140 layout)
+	vec3 in std140 are aligned on 16 bytes -> use vec4 on the cpu side
+*/
+struct PerFrameUbo {
+	glm::mat4	projection;
+	glm::mat4	view;
+	glm::mat4	textProjection;
+	glm::vec4	viewPos;
+	glm::vec4	dirLightDirection;
+	glm::vec4	dirLightAmbient;
+	glm::vec4	dirLightDiffuse;
+	glm::vec4	dirLightSpecular;
+};
+
+/*
+	UniformBuffer class used to manage an uniform buffer object (UBO)
+	the buffer is bound on bindingPoint, each Shader using the block need to call
+	Shader::bindUniformBlock with the same bindingPoint
+*/
+class UniformBuffer {
+	public:
+		UniformBuffer(GLuint bindingPoint, GLsizeiptr size);
+		virtual ~UniformBuffer();
+
+		/* the buffer is owned (deleted in the destructor), a copy would delete it twice */
+		UniformBuffer(UniformBuffer const &src) = delete;
+		UniformBuffer &operator=(UniformBuffer const &rhs) = delete;
+
+		void	update(void const *data, GLsizeiptr size, GLintptr offset = 0);
+
+		GLuint		getID() const;
+		GLuint		getBindingPoint() const;
+		GLsizeiptr	getSize() const;
+
+	private:
+		GLuint		_id;
+		GLuint		_bindingPoint;
+		GLsizeiptr	_size;
+};
+
+#endif  // UNIFORMBUFFER_HPP_
@@ -0,0 +1,55 @@
+#version 410 core
+
+#define GAMMA 2.2
+#define CELL_EMPTY 0
+#define NB_CELL_TYPES 11  // BoardCell::NB_TYPES in NibblerOpenGL.hpp
+
+out vec4	FragColor;
+
+in VS_OUT {
+	vec3 FragPos;
+} fs_in;
+
+struct DirLight {
+	vec3		direction;
+
+	vec3		ambient;
+	vec3		diffuse;
+	vec3		specular;
+};
+
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
+
+uniform sampler2D	board;  // R8 texture, one texel per cell (cell type)
+uniform int			boardSize;
+uniform vec4		cellColors[NB_CELL_TYPES];  // color of each cell type
+uniform vec4		squareColor2;  // second color of the empty squares (first is cellColors[CELL_EMPTY])
+
+void main() {
+	ivec2 cell = clamp(ivec2(floor(fs_in.FragPos.xz + 0.5)), ivec2(0), ivec2(boardSize - 1));
+	int type = int(texelFetch(board, cell, 0).r * 255.0 + 0.5);
+
+	vec3 color;
+	if (type == CELL_EMPTY && ((cell.x + cell.y) & 1) == 0)
+		color = vec3(squareColor2);
+	else
+		color = vec3(cellColors[min(type, NB_CELL_TYPES - 1)]);
+
+	// directional lighting on a flat board (normal = up)
+	vec3	norm = vec3(0.0, 1.0, 0.0);
+	vec3	lightDir = normalize(-dirLight.direction);
+	float	diff = max(dot(norm, lightDir), 0.0);
+	vec3	res = dirLight.ambient * color + dirLight.diffuse * diff * color;
+
+	FragColor = vec4(res, 1.0);
+
+	// apply gamma correction
+    FragColor.rgb = pow(FragColor.rgb, vec3(1.0 / GAMMA));
+}
@@ -0,0 +1,29 @@
+#version 410 core
+
+layout (location = 0) in vec3 aPos;  // corners of the board quad
+
+struct DirLight {
+	vec3		direction;
+
+	vec3		ambient;
+	vec3		diffuse;
+	vec3		specular;
+};
+
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
+
+out VS_OUT {
+	vec3 FragPos;
+} vs_out;
+
+void main() {
+	vs_out.FragPos = aPos;
+	gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
+}
@@ -7,6 +7,7 @@ out vec4	FragColor;
 in VS_OUT {
 	vec3 FragPos;
 	vec3 Normal;
+	vec4 Color;
 } fs_in;
 
 struct	Material {
@@ -22,6 +23,15 @@ struct DirLight {
 	vec3		specular;
 };
 
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
+
 struct PointLight {
     bool		enabled;
     vec3		position;
@@ -35,10 +45,7 @@ struct PointLight {
     vec3		specular;
 };
 
-uniform vec4		color;
-uniform vec3		viewPos;
 uniform Material	material;
-uniform DirLight	dirLight;
 uniform PointLight	pointLight;
 
 vec3 calcDirLight(DirLight light, vec3 norm, vec3 viewDir) {
@@ -53,7 +60,7 @@ vec3 calcDirLight(DirLight light, vec3 norm, vec3 viewDir) {
 	vec3	ambient = light.ambient;
 	vec3	diffuse = light.diffuse;
 
-	vec3 tmp = vec3(color);
+	vec3 tmp = vec3(fs_in.Color);
 	ambient *= tmp;
 	diffuse *= diff * tmp;
 
@@ -75,7 +82,7 @@ vec3 calcPointLight(PointLight light, vec3 norm, vec3 fragPos, vec3 viewDir) {
 	vec3	ambient = light.ambient;
 	vec3	diffuse = light.diffuse;
 
-	vec3 tmp = vec3(color);
+	vec3 tmp = vec3(fs_in.Color);
 	ambient *= tmp;
 	diffuse *= diff * tmp;
 
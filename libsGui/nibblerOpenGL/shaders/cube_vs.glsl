@@ -2,18 +2,35 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aOffset;  // per instance: position of the cube
+layout (location = 3) in vec4 aColor;  // per instance: color of the cube
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+struct DirLight {
+	vec3		direction;
+
+	vec3		ambient;
+	vec3		diffuse;
+	vec3		specular;
+};
+
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
 
 out VS_OUT {
 	vec3 FragPos;
 	vec3 Normal;
+	vec4 Color;
 } vs_out;
 
 void main() {
-	vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
+	vs_out.FragPos = aPos + aOffset;
 	vs_out.Normal = aNormal;
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	vs_out.Color = aColor;
+	gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
 }
@@ -3,12 +3,26 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 texCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+struct DirLight {
+	vec3		direction;
+
+	vec3		ambient;
+	vec3		diffuse;
+	vec3		specular;
+};
+
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
 
 void main()
 {
     texCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    vec4 pos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);  // remove translation for the skybox
     gl_Position = pos.xyww;
 }
\ No newline at end of file
@@ -4,10 +4,25 @@ layout (location = 0) in vec4 vertex;  // <vec2 pos, vec2 tex>
 
 out vec2 TexCoords;
 
-uniform mat4 projection;
+struct DirLight {
+	vec3		direction;
+
+	vec3		ambient;
+	vec3		diffuse;
+	vec3		specular;
+};
+
+// per frame data, shared by all shaders (PerFrameUbo in UniformBuffer.hpp)
+layout (std140) uniform PerFrame {
+	mat4		projection;
+	mat4		view;
+	mat4		textProjection;
+	vec3		viewPos;
+	DirLight	dirLight;
+};
 
 void main()
 {
-    gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
+    gl_Position = textProjection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
 }
\ No newline at end of file
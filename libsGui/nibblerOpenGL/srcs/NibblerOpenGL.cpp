@@ -1,5 +1,9 @@
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
 #include "NibblerOpenGL.hpp"
 #include "Logging.hpp"
+#include "Tracer.hpp"
 #include "debug.hpp"
 #include "Material.hpp"
 
@@ -72,7 +76,37 @@ NibblerOpenGL::NibblerOpenGL() :
   _cam(nullptr),
   _textRender(nullptr),
   _skybox(nullptr),
-  _lastLoopMs(0) {
+  _cubeShaderVAO(0),
+  _cubeShaderVBO(0),
+  _boardInstanceVBO(0),
+  _nbBoardInstances(0),
+  _boardInstancesSize(0),
+  _entitiesVAO(0),
+  _entitiesInstanceVBO(0),
+  _entitiesInstances(),
+  _boardChunks(),
+  _visibleChunks(),
+  _nbVisibleChunks(0),
+  _nbChunksX(0),
+  _boardChunksSize(0),
+  _boardShader(nullptr),
+  _boardTexture(0),
+  _boardTextureSize(0),
+  _boardQuadVAO(0),
+  _boardQuadVBO(0),
+  _boardCells(),
+  _nextCells(),
+  _paintedCells(),
+  _frameCells(),
+  _dirtyCells(),
+  _perFrameUbo(nullptr),
+  _perFrame(),
+  _lastLoopMs(0),
+  _passTimer(nullptr),
+  _showPassTimes(false),
+  _hudState(),
+  _hudTexts(),
+  _nbHudTexts(0) {
 	// init logging
 	#if DEBUG
 		logging.setLoglevel(LOGDEBUG);
@@ -88,16 +122,35 @@ NibblerOpenGL::~NibblerOpenGL() {
 	logInfo("exit OpenGL");
 	SDL_ShowCursor(SDL_ENABLE);
 	SDL_SetRelativeMouseMode(SDL_FALSE);
+	if (_win != nullptr && _context != 0)
+		SDL_GL_MakeCurrent(_win, _context);  // another resident GUI may own the current context
 	glDeleteBuffers(1, &_cubeShaderVBO);
+	glDeleteBuffers(1, &_boardInstanceVBO);
+	glDeleteBuffers(1, &_entitiesInstanceVBO);
 	glDeleteVertexArrays(1, &_cubeShaderVAO);
+	glDeleteVertexArrays(1, &_entitiesVAO);
+	glDeleteBuffers(1, &_boardQuadVBO);
+	glDeleteVertexArrays(1, &_boardQuadVAO);
+	glDeleteTextures(1, &_boardTexture);
+	if (_textRender != nullptr) {
+		for (auto it = _hudTexts.begin(); it != _hudTexts.end(); it++) {
+			_textRender->deleteText(*it);
+		}
+	}
+	if (_passTimer != nullptr) {
+		logInfo("OpenGL render passes:" << _passTimer->getReport());
+	}
+	delete _passTimer;
+	delete _perFrameUbo;
 	delete _cubeShader;
+	delete _boardShader;
 	delete _textRender;
 	delete _skybox;
 	delete _cam;
 	delete _event;
 	SDL_GL_DeleteContext(_context);
 	SDL_DestroyWindow(_win);
-    SDL_Quit();
+	SDL_QuitSubSystem(SDL_INIT_VIDEO);  // other resident libs can still use SDL
 }
 
 NibblerOpenGL::NibblerOpenGL(NibblerOpenGL const &src) {
@@ -119,11 +172,27 @@ float mapFloat(float x, float in_min, float in_max, float out_min, float out_max
 bool NibblerOpenGL::_init() {
 	logInfo("loading OpenGL");
 
+	// decode the skybox & rasterize the fonts on worker threads while the window is created
+	// (only the GL uploads are done on this thread)
+	std::vector<std::future<Skybox::Image> > skyboxFaces = Skybox::decodeFacesAsync(Skybox::getDefaultFaces());
+	_textBasicHeight = _gameInfo->width / 40;
+	_textTitleHeight = _gameInfo->width / 10;
+	auto rasterize = [this](uint32_t height) {
+		TRACE_SCOPE(_tracer, "rasterize font", height);
+		return TextRender::rasterizeFont(_gameInfo->font, height);
+	};
+	std::future<TextRender::GlyphSet> basicFont = std::async(std::launch::async, rasterize,
+		static_cast<uint32_t>(_textBasicHeight));
+	std::future<TextRender::GlyphSet> titleFont = std::async(std::launch::async, rasterize,
+		static_cast<uint32_t>(_textTitleHeight));
+
+	uint64_t phaseStart = (_tracer != nullptr) ? _tracer->begin() : 0;
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         logErr("while loading OpenGL: " << SDL_GetError());
-        SDL_Quit();
 		return false;
     }
+	if (_tracer != nullptr)
+		phaseStart = _tracer->end("SDL_Init video", phaseStart);
 
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
@@ -143,6 +212,8 @@ bool NibblerOpenGL::_init() {
         logErr("while loading OpenGL: " << SDL_GetError());
 		return false;
 	}
+	if (_tracer != nullptr)
+		phaseStart = _tracer->end("create window", phaseStart);
 
 	_context = SDL_GL_CreateContext(_win);
     if (_context == 0) {
@@ -154,6 +225,8 @@ bool NibblerOpenGL::_init() {
         logErr("while loading OpenGL: failed to init glad");
         return false;
 	}
+	if (_tracer != nullptr)
+		phaseStart = _tracer->end("create GL context", phaseStart);
 
 	glEnable(GL_MULTISAMPLE);  // anti aliasing
 	glEnable(GL_CULL_FACE);  // face culling
@@ -163,12 +236,20 @@ bool NibblerOpenGL::_init() {
 
 	try {
 		_cubeShader = new Shader(CUBE_VS_PATH, CUBE_FS_PATH);
+		_cubeShader->bindUniformBlock(PER_FRAME_UBO_NAME, PER_FRAME_UBO_BINDING);
+		_boardShader = new Shader(BOARD_VS_PATH, BOARD_FS_PATH);
+		_boardShader->bindUniformBlock(PER_FRAME_UBO_NAME, PER_FRAME_UBO_BINDING);
+		if (_tracer != nullptr)
+			phaseStart = _tracer->end("compile shaders", phaseStart);
 		_textRender = new TextRender(_gameInfo->realWidth, _gameInfo->realHeight);
-		_textBasicHeight = _gameInfo->width / 40;
-		_textRender->loadFont("basicFont", _gameInfo->font, _textBasicHeight);
-		_textTitleHeight = _gameInfo->width / 10;
-		_textRender->loadFont("titleFont", _gameInfo->font, _textTitleHeight);
-		_skybox = new Skybox;
+		_textRender->loadFont("basicFont", basicFont.get());
+		_textRender->loadFont("titleFont", titleFont.get());
+		if (_tracer != nullptr)
+			phaseStart = _tracer->end("upload fonts", phaseStart);
+		_skybox = new Skybox(skyboxFaces);
+		if (_tracer != nullptr)
+			phaseStart = _tracer->end("skybox", phaseStart);
+		_passTimer = new PassTimer({"board", "snakes", "skybox", "text"});
 	}
 	catch (Shader::ShaderError & e) {
         logErr("while loading OpenGL: " << e.what());
@@ -192,50 +273,92 @@ bool NibblerOpenGL::_init() {
 	float nearD = 0.1f;
 	float farD = 400;
 	_projection = glm::perspective(glm::radians(angle), ratio, nearD, farD);
+	_cam->frustumCullingInit(angle, ratio, nearD, farD);
 
-	glGenVertexArrays(1, &_cubeShaderVAO);
-    glGenBuffers(1, &(_cubeShaderVBO));
-
-    glBindBuffer(GL_ARRAY_BUFFER, _cubeShaderVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(NibblerOpenGL::_cubeVertices), NibblerOpenGL::_cubeVertices, GL_STATIC_DRAW);
+	glGenBuffers(1, &_cubeShaderVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, _cubeShaderVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(NibblerOpenGL::_cubeVertices), NibblerOpenGL::_cubeVertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(_cubeShaderVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, SIZE_LINE * sizeof(float),
-		reinterpret_cast<void*>(0));
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, SIZE_LINE * sizeof(float),
-		reinterpret_cast<void*>(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+	// one VAO for the board instances and one for the entities instances
+	glGenBuffers(1, &_boardInstanceVBO);
+	glGenBuffers(1, &_entitiesInstanceVBO);
+	glGenVertexArrays(1, &_cubeShaderVAO);
+	glGenVertexArrays(1, &_entitiesVAO);
+	_initCubeVAO(_cubeShaderVAO, _boardInstanceVBO);
+	_initCubeVAO(_entitiesVAO, _entitiesInstanceVBO);
+
+	// per frame data shared by all shaders
+	_perFrameUbo = new UniformBuffer(PER_FRAME_UBO_BINDING, sizeof(PerFrameUbo));
+	_perFrame.projection = _projection;
+	_perFrame.textProjection = _textRender->getProjection();
+	// set direction light
+	_perFrame.dirLightDirection = glm::vec4(-0.2f, -0.8f, 0.6f, 0.0f);
+	_perFrame.dirLightAmbient = glm::vec4(0.4f, 0.4f, 0.4f, 0.0f);
+	_perFrame.dirLightDiffuse = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+	_perFrame.dirLightSpecular = glm::vec4(0.1f, 0.1f, 0.1f, 0.0f);
 
-	_skybox->getShader().use();
-	_skybox->getShader().setMat4("projection", _projection);
-	_skybox->getShader().unuse();
 	_cubeShader->use();
-	_cubeShader->setMat4("projection", _projection);
 	// set cube material
 	Material material;
 	_cubeShader->setVec3("material.specular", material.specular);
 	_cubeShader->setFloat("material.shininess", material.shininess);
 
-	// set direction light
-	_cubeShader->setVec3("dirLight.direction", -0.2f, -0.8f, 0.6f);
-	_cubeShader->setVec3("dirLight.ambient", 0.4f, 0.4f, 0.4f);
-	_cubeShader->setVec3("dirLight.diffuse", 0.8f, 0.8f, 0.8f);
-	_cubeShader->setVec3("dirLight.specular", 0.1f, 0.1f, 0.1f);
-
 	// set point light
 	_cubeShader->setBool("pointLight.enabled", false);
+	_cubeShader->unuse();
+
+	// board texture: colors of each cell type
+	glGenVertexArrays(1, &_boardQuadVAO);
+	glGenBuffers(1, &_boardQuadVBO);
+	glBindVertexArray(_boardQuadVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, _boardQuadVBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), reinterpret_cast<void*>(0));
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glm::vec4 cellColors[BoardCell::NB_TYPES];
+	cellColors[BoardCell::EMPTY] = TO_OPENGL_COLOR(SQUARE_COLOR_1);
+	cellColors[BoardCell::WALL] = TO_OPENGL_COLOR(WALL_COLOR);
+	cellColors[BoardCell::FOOD] = TO_OPENGL_COLOR(FOOD_COLOR);
+	cellColors[BoardCell::BONUS] = TO_OPENGL_COLOR(BONUS_COLOR);
+	cellColors[BoardCell::SNAKE_BONUS] = TO_OPENGL_COLOR(BONUS_COLOR);
+	for (int id = 0; id < BoardCell::NB_TYPES - BoardCell::SNAKE; id++) {
+		cellColors[BoardCell::SNAKE + id] = TO_OPENGL_COLOR(getColor(id, 1));
+	}
+	_boardShader->use();
+	_boardShader->setInt("board", 0);
+	glUniform4fv(_boardShader->getUniformLocation("cellColors"), BoardCell::NB_TYPES, &cellColors[0][0]);
+	_boardShader->setVec4("squareColor2", TO_OPENGL_COLOR(SQUARE_COLOR_2));
+	_boardShader->unuse();
 
 	_lastLoopMs = getMs().count();
 
     return true;
 }
 
+void NibblerOpenGL::_setActive(bool active) {
+	if (active) {
+		SDL_ShowWindow(_win);
+		SDL_RaiseWindow(_win);
+		SDL_GL_MakeCurrent(_win, _context);
+		SDL_ShowCursor(SDL_DISABLE);
+		SDL_SetRelativeMouseMode(SDL_TRUE);
+		_lastLoopMs = getMs().count();  // don't move the camera with the time spent hidden
+	}
+	else {
+		SDL_ShowCursor(SDL_ENABLE);
+		SDL_SetRelativeMouseMode(SDL_FALSE);
+		SDL_HideWindow(_win);
+	}
+}
+
 void NibblerOpenGL::updateInput() {
 	uint64_t time = getMs().count();
 	float dtTime = (time - _lastLoopMs) / 1000.0;
 	_lastLoopMs = time;
 	while (SDL_PollEvent(_event)) {
+		if (_event->type == SDL_WINDOWEVENT)
+			_needRedraw = true;  // exposed, resized...
 		if (_event->window.event == SDL_WINDOWEVENT_CLOSE)
 			input.quit = true;
 		if (_event->key.type == SDL_KEYDOWN) {
@@ -246,6 +369,12 @@ void NibblerOpenGL::updateInput() {
 				input.paused = !input.paused;
 			else if (_event->key.keysym.sym == SDLK_r)
 				input.restart = true;
+			else if (_event->key.keysym.sym == SDLK_F3) {
+				_showPassTimes = !_showPassTimes;
+				_needRedraw = true;
+			}
+			else if (_event->key.keysym.sym == SDLK_F12)
+				input.saveTrace = true;
 
 			else if (_event->key.keysym.sym == SDLK_UP)
 				input.direction[0] = Direction::MOVE_UP;
@@ -277,10 +406,14 @@ void NibblerOpenGL::updateInput() {
 		}
 
 		if (_event->type == SDL_MOUSEMOTION) {
-			if (_gameInfo->nbPlayers == 1 || _gameInfo->isIA[1])  // move camera only on singlePlayer
+			if (_gameInfo->nbPlayers == 1 || _gameInfo->isIA[1]) {  // move camera only on singlePlayer
 				_cam->processMouseMovement(_event->motion.xrel, -_event->motion.yrel);
+				_needRedraw = true;
+			}
 		}
 	}
+	if (_showPassTimes)
+		_needRedraw = true;  // the pass times overlay change each frame
 
 	const Uint8 * keystates = SDL_GetKeyboardState(NULL);
 
@@ -304,6 +437,9 @@ void NibblerOpenGL::updateInput() {
 			_cam->processKeyboard(CamMovement::Up, dtTime, isRun);
 		if (keystates[SDL_SCANCODE_Q])
 			_cam->processKeyboard(CamMovement::Down, dtTime, isRun);
+		if (keystates[SDL_SCANCODE_W] || keystates[SDL_SCANCODE_S] || keystates[SDL_SCANCODE_A]
+		|| keystates[SDL_SCANCODE_D] || keystates[SDL_SCANCODE_E] || keystates[SDL_SCANCODE_Q])
+			_needRedraw = true;  // the camera moved
 	}
 	else {if (keystates[SDL_SCANCODE_LSHIFT])
 		input.usingBonus[1] = true;
@@ -312,148 +448,444 @@ void NibblerOpenGL::updateInput() {
 	}
 }
 
+/*
+block on the event queue: an input wake up the game loop before the end of the frame
+the mouse motions wake it up too (camera), the game still draw at most once per frame
+*/
+void NibblerOpenGL::waitInput(uint32_t timeoutUs) {
+	if (timeoutUs >= 1000)
+		SDL_WaitEventTimeout(NULL, timeoutUs / 1000);  // NULL: the event stays in the queue for updateInput
+}
+
 bool NibblerOpenGL::draw() {
+	TRACE_SCOPE(_tracer, "NibblerOpenGL::draw");
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glViewport(0, 0, _gameInfo->realWidth, _gameInfo->realHeight);
     glClearColor(0.11373f, 0.17647f, 0.27059f, 1.0f);
 
-	CAMERA_MAT4 view = _cam->getViewMatrix();
+	// upload per frame data (camera) for all shaders
+	_perFrame.view = _cam->getViewMatrix();
+	_perFrame.viewPos = glm::vec4(glm::vec3(_cam->pos), 1.0f);
+	_perFrameUbo->update(&_perFrame, sizeof(PerFrameUbo));
 
-	_cubeShader->use();
-	_cubeShader->setMat4("view", view);
-	_cubeShader->setVec3("viewPos", _cam->pos);
-	glBindVertexArray(_cubeShaderVAO);
-	_cubeShader->unuse();
+	// frustum culling of the board tiles
+	if (_boardChunksSize != _gameInfo->boardSize) {
+		_buildBoardChunks();
+	}
+	_updateVisibleChunks();
 
-	CAMERA_MAT4	skyView = view;
-	skyView[3][0] = 0;  // remove translation for the skybox
-	skyView[3][1] = 0;
-	skyView[3][2] = 0;
-	_skybox->getShader().use();
-	_skybox->getShader().setMat4("view", skyView);
-	_skybox->getShader().unuse();
+	// draw board & entities
+	if (_gameInfo->boardSize >= BOARD_TEXTURE_MIN_SIZE)
+		_drawBoardTexture();
+	else
+		_drawBoardCubes();
 
+	_passTimer->begin(RenderPass::SKYBOX);
+	_skybox->draw(0.3);
+	_passTimer->end(RenderPass::SKYBOX);
+
+	// text (re-layout only if the values changed)
+	_passTimer->begin(RenderPass::TEXT);
+	if (_hudState.update(*_gameInfo)) {
+		_buildHud();
+	}
+	for (size_t i = 0; i < _nbHudTexts; i++) {
+		_textRender->draw(_hudTexts[i]);
+	}
+	if (_showPassTimes) {
+		_drawPassTimes();
+	}
+	_passTimer->end(RenderPass::TEXT);
+	_passTimer->endFrame();
+
+    SDL_GL_SwapWindow(_win);
+	checkError();
+	return true;
+}
+
+/*
+set the cube mesh (location 0 & 1) and the per instance data (location 2 & 3) on a VAO
+*/
+void NibblerOpenGL::_initCubeVAO(uint32_t vao, uint32_t instanceVBO) {
+	glBindVertexArray(vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, _cubeShaderVBO);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, SIZE_LINE * sizeof(float),
+		reinterpret_cast<void*>(0));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, SIZE_LINE * sizeof(float),
+		reinterpret_cast<void*>(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	_setInstanceOffset(instanceVBO, 0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(3);
+	glVertexAttribDivisor(3, 1);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/*
+point the per instance attributes (location 2 & 3) of the bound VAO on firstInstance of instanceVBO
+(no glDrawArraysInstancedBaseInstance in OpenGL 4.1)
+*/
+void NibblerOpenGL::_setInstanceOffset(uint32_t instanceVBO, uint32_t firstInstance) {
+	size_t offset = firstInstance * sizeof(CubeInstance);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+		reinterpret_cast<void*>(offset + offsetof(CubeInstance, pos)));
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance),
+		reinterpret_cast<void*>(offset + offsetof(CubeInstance, color)));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+draw the board squares & all entities as cubes (instanced)
+*/
+void NibblerOpenGL::_drawBoardCubes() {
+	_passTimer->begin(RenderPass::BOARD);
 	_cubeShader->use();
-	glm::mat4 model(1.0);
-	glm::vec3 pos = glm::vec3(0.0, 0.0, 0.0);
-
-	// draw board
-	for (int i = 0; i < _gameInfo->boardSize; i++) {
-		for (int j = 0; j < _gameInfo->boardSize; j++) {
-			pos.x = i;
-			pos.z = j;
-			uint32_t color = ((i + j) & 1) ? SQUARE_COLOR_1 : SQUARE_COLOR_2;
-			model = glm::translate(glm::mat4(1.0), pos);
-			_cubeShader->setVec4("color", TO_OPENGL_COLOR(color));
-			_cubeShader->setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+
+	// draw board (instances are rebuilt only if the boardSize change)
+	if (_boardInstancesSize != _gameInfo->boardSize) {
+		_buildBoardInstances();
+	}
+	// instances are sorted by chunk: one draw for each run of consecutive visible chunks
+	glBindVertexArray(_cubeShaderVAO);
+	size_t i = 0;
+	while (i < _boardChunks.size()) {
+		if (!_visibleChunks[i]) {
+			i++;
+			continue;
+		}
+		uint32_t first = _boardChunks[i].firstInstance;
+		uint32_t nbInstances = 0;
+		while (i < _boardChunks.size() && _visibleChunks[i]) {
+			nbInstances += _boardChunks[i].nbInstances;
+			i++;
 		}
+		_setInstanceOffset(_boardInstanceVBO, first);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, NB_CUBE_VERTICES, nbInstances);
 	}
+	_passTimer->end(RenderPass::BOARD);
+
+	// snakes, wall, food & bonus in one instances buffer (only in visible chunks)
+	_passTimer->begin(RenderPass::SNAKES);
+	_entitiesInstances.clear();
 	// draw snakes
-	pos.y = 1;
 	for (int id = 0; id < _gameInfo->nbPlayers; id++) {
 		int		i = 0;
 		float	max = (_gameInfo->snakes[id].size() == 1) ? 1 : _gameInfo->snakes[id].size() - 1;
 		for (auto it = _gameInfo->snakes[id].begin(); it != _gameInfo->snakes[id].end(); it++) {
-			pos.x = it->x;
-			pos.z = it->y;
 			uint32_t	color = mixColor(getColor(id, 1), getColor(id, 2), i / max);
 			if (i >= 1 && max - i < _gameInfo->nbBonus[id])
 				color = BONUS_COLOR;
-			model = glm::translate(glm::mat4(1.0), pos);
-			_cubeShader->setVec4("color", TO_OPENGL_COLOR(color));
-			_cubeShader->setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			if (_isCellVisible(it->x, it->y))
+				_addCubeInstance(_entitiesInstances, it->x, 1, it->y, color);
 			i++;
 		}
 	}
 	// draw wall
-	pos.y = 1;
 	for (auto it = _gameInfo->wall.begin(); it != _gameInfo->wall.end(); it++) {
-		pos.x = it->pos.x;
-		pos.z = it->pos.y;
-		model = glm::translate(glm::mat4(1.0), pos);
-		_cubeShader->setVec4("color", TO_OPENGL_COLOR(WALL_COLOR));
-		_cubeShader->setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, sizeof(_cubeVertices) / (sizeof(float) * SIZE_LINE));
+		if (_isCellVisible(it->pos.x, it->pos.y))
+			_addCubeInstance(_entitiesInstances, it->pos.x, 1, it->pos.y, WALL_COLOR);
 	}
 	// draw food
-	pos.y = 1;
 	for (auto it = _gameInfo->food.begin(); it != _gameInfo->food.end(); it++) {
-		pos.x = it->x;
-		pos.z = it->y;
-		model = glm::translate(glm::mat4(1.0), pos);
-		_cubeShader->setVec4("color", TO_OPENGL_COLOR(FOOD_COLOR));
-		_cubeShader->setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, sizeof(_cubeVertices) / (sizeof(float) * SIZE_LINE));
+		if (_isCellVisible(it->x, it->y))
+			_addCubeInstance(_entitiesInstances, it->x, 1, it->y, FOOD_COLOR);
 	}
 	// draw bonus
-	pos.y = 1;
 	for (auto it = _gameInfo->bonus.begin(); it != _gameInfo->bonus.end(); it++) {
-		pos.x = it->x;
-		pos.z = it->y;
-		model = glm::translate(glm::mat4(1.0), pos);
-		_cubeShader->setVec4("color", TO_OPENGL_COLOR(BONUS_COLOR));
-		_cubeShader->setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, sizeof(_cubeVertices) / (sizeof(float) * SIZE_LINE));
+		if (_isCellVisible(it->x, it->y))
+			_addCubeInstance(_entitiesInstances, it->x, 1, it->y, BONUS_COLOR);
 	}
+	if (_entitiesInstances.size() > 0) {
+		glBindBuffer(GL_ARRAY_BUFFER, _entitiesInstanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(CubeInstance) * _entitiesInstances.size(), _entitiesInstances.data(),
+			GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(_entitiesVAO);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, NB_CUBE_VERTICES, _entitiesInstances.size());
+	}
+	glBindVertexArray(0);
 	_cubeShader->unuse();
+	_passTimer->end(RenderPass::SNAKES);
+}
 
-	_skybox->draw(0.3);
+/*
+upload the board squares in _boardInstanceVBO
+this is called only when the boardSize change
+*/
+void NibblerOpenGL::_buildBoardInstances() {
+	std::vector<CubeInstance> instances;
+	instances.reserve(_gameInfo->boardSize * _gameInfo->boardSize);
+	for (auto chunk = _boardChunks.begin(); chunk != _boardChunks.end(); chunk++) {
+		chunk->firstInstance = instances.size();
+		int startX = chunk->start.x + 0.5f;
+		int startZ = chunk->start.z + 0.5f;
+		for (int i = startX; i < startX + chunk->size.x; i++) {
+			for (int j = startZ; j < startZ + chunk->size.z; j++) {
+				uint32_t color = ((i + j) & 1) ? SQUARE_COLOR_1 : SQUARE_COLOR_2;
+				_addCubeInstance(instances, i, 0, j, color);
+			}
+		}
+		chunk->nbInstances = instances.size() - chunk->firstInstance;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, _boardInstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(CubeInstance) * instances.size(), instances.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	_nbBoardInstances = instances.size();
+	_boardInstancesSize = _gameInfo->boardSize;
+}
 
-	// text
-    {
-		int x = 20;
-		int y = _gameInfo->realHeight - _textBasicHeight - 10;
-		int lineSz = _textBasicHeight * 1.2;
-		std::string text;
-		if (_gameInfo->nbPlayers == 1) {
-			text = "Score: " + std::to_string(_gameInfo->scores[0]);
-			_textRender->write("basicFont", text, x, y, 1, TO_OPENGL_COLOR(getColor(0, 1)));
-			y -= lineSz;
+void NibblerOpenGL::_addCubeInstance(std::vector<CubeInstance> &instances, int x, int y, int z, uint32_t color) {
+	CubeInstance instance;
+	instance.pos = glm::vec3(x, y, z);
+	instance.color = TO_OPENGL_COLOR(color);
+	instances.push_back(instance);
+}
+
+// -- frustum culling ----------------------------------------------------------
+
+/*
+split the board in BOARD_CHUNK_SIZE tiles
+the bounding box of a tile contains the board cubes (y = 0) and the entities (y = 1)
+*/
+void NibblerOpenGL::_buildBoardChunks() {
+	int size = _gameInfo->boardSize;
+	_nbChunksX = (size + BOARD_CHUNK_SIZE - 1) / BOARD_CHUNK_SIZE;
+	_boardChunks.clear();
+	for (int z = 0; z < size; z += BOARD_CHUNK_SIZE) {
+		for (int x = 0; x < size; x += BOARD_CHUNK_SIZE) {
+			BoardChunk chunk;
+			chunk.start = glm::vec3(x - 0.5f, -0.5f, z - 0.5f);
+			chunk.size = glm::vec3(std::min(BOARD_CHUNK_SIZE, size - x), 2.0f, std::min(BOARD_CHUNK_SIZE, size - z));
+			chunk.firstInstance = 0;
+			chunk.nbInstances = 0;
+			_boardChunks.push_back(chunk);
 		}
-		else {
-			for (int id = 0; id < _gameInfo->nbPlayers; id++) {
-				text = "Score ";
-				if (_gameInfo->isIA[id])
-					text += "[IA] ";
-				else if (id == 0)
-					text += "[arrow] ";
-				else
-					text += "[wasd] ";
-				text += std::to_string(id + 1) + " : " + std::to_string(_gameInfo->scores[id]);
-				uint32_t color = (_gameInfo->snakes[id].size() > 0) ? getColor(id, 1) : TEXT_COLOR;
-				_textRender->write("basicFont", text, x, y, 1, TO_OPENGL_COLOR(color));
-				y -= lineSz;
-			}
+	}
+	_visibleChunks.assign(_boardChunks.size(), true);
+	_nbVisibleChunks = _boardChunks.size();
+	_boardChunksSize = size;
+	_boardInstancesSize = 0;  // instances are sorted by chunk, rebuild them
+}
+
+/*
+test each chunk once against the camera frustum
+*/
+void NibblerOpenGL::_updateVisibleChunks() {
+	_nbVisibleChunks = 0;
+	for (size_t i = 0; i < _boardChunks.size(); i++) {
+		CAMERA_VEC3 start(_boardChunks[i].start);
+		CAMERA_VEC3 size(_boardChunks[i].size);
+		_visibleChunks[i] = FRCL_IS_INSIDE(_cam->frustumCullingCheckCube(start, size));
+		if (_visibleChunks[i])
+			_nbVisibleChunks++;
+	}
+}
+
+/*
+return true if the chunk of the cell is visible (cells outside of the board are always drawn)
+*/
+bool NibblerOpenGL::_isCellVisible(int x, int y) const {
+	if (x < 0 || y < 0 || x >= _boardChunksSize || y >= _boardChunksSize)
+		return true;
+	return _visibleChunks[(y / BOARD_CHUNK_SIZE) * _nbChunksX + x / BOARD_CHUNK_SIZE];
+}
+
+// -- board texture ------------------------------------------------------------
+
+/*
+draw the board & all entities on a single quad, the cell types are read from _boardTexture
+only the cells that changed since the last frame are uploaded
+*/
+void NibblerOpenGL::_drawBoardTexture() {
+	if (_boardTextureSize != _gameInfo->boardSize) {
+		_initBoardTexture();
+	}
+
+	// paint all entities in _nextCells
+	_passTimer->begin(RenderPass::SNAKES);
+	_frameCells.clear();
+	for (int id = 0; id < _gameInfo->nbPlayers; id++) {
+		int		i = 0;
+		float	max = (_gameInfo->snakes[id].size() == 1) ? 1 : _gameInfo->snakes[id].size() - 1;
+		for (auto it = _gameInfo->snakes[id].begin(); it != _gameInfo->snakes[id].end(); it++) {
+			uint8_t type = BoardCell::SNAKE + id % 6;
+			if (i >= 1 && max - i < _gameInfo->nbBonus[id])
+				type = BoardCell::SNAKE_BONUS;
+			_paintCell(it->x, it->y, type);
+			i++;
 		}
-		text = "Best: " + std::to_string(_gameInfo->bestScore);
-		_textRender->write("basicFont", text, x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
+	}
+	for (auto it = _gameInfo->wall.begin(); it != _gameInfo->wall.end(); it++) {
+		_paintCell(it->pos.x, it->pos.y, BoardCell::WALL);
+	}
+	for (auto it = _gameInfo->food.begin(); it != _gameInfo->food.end(); it++) {
+		_paintCell(it->x, it->y, BoardCell::FOOD);
+	}
+	for (auto it = _gameInfo->bonus.begin(); it != _gameInfo->bonus.end(); it++) {
+		_paintCell(it->x, it->y, BoardCell::BONUS);
+	}
 
-		y = 10;
-		_textRender->write("basicFont", "r: restart", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
-		y += lineSz;
-		_textRender->write("basicFont", "space: pause", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
-		if (_gameInfo->nbPlayers == 1 || _gameInfo->isIA[1]) {
-			y += lineSz;
-			_textRender->write("basicFont", "[wasd]: move camera", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
-			y += lineSz;
-			_textRender->write("basicFont", "[ed]: move camera (up-down)", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
+	// diff with the last frame (new or changed cells, then cells that became empty)
+	_dirtyCells.clear();
+	for (auto it = _frameCells.begin(); it != _frameCells.end(); it++) {
+		if (_boardCells[*it] != _nextCells[*it]) {
+			_boardCells[*it] = _nextCells[*it];
+			_dirtyCells.push_back(*it);
 		}
-		else {
-			y += lineSz;
-			_textRender->write("basicFont", "Lshift: bonus player 2", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
-			y += lineSz;
-			_textRender->write("basicFont", "[wasd]: move player 2", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
+	}
+	for (auto it = _paintedCells.begin(); it != _paintedCells.end(); it++) {
+		if (_nextCells[*it] == BoardCell::EMPTY && _boardCells[*it] != BoardCell::EMPTY) {
+			_boardCells[*it] = BoardCell::EMPTY;
+			_dirtyCells.push_back(*it);
+		}
+	}
+	for (auto it = _frameCells.begin(); it != _frameCells.end(); it++) {
+		_nextCells[*it] = BoardCell::EMPTY;
+	}
+	_paintedCells.swap(_frameCells);
+
+	// upload the changed cells (whole texture if there is more than a row of changes)
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, _boardTexture);
+	uint32_t size = _boardTextureSize;
+	if (_dirtyCells.size() > size) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, GL_UNSIGNED_BYTE, _boardCells.data());
+	}
+	else {
+		for (auto it = _dirtyCells.begin(); it != _dirtyCells.end(); it++) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, *it % size, *it / size, 1, 1, GL_RED, GL_UNSIGNED_BYTE,
+				&_boardCells[*it]);
+		}
+	}
+	_passTimer->end(RenderPass::SNAKES);
+
+	// the board is a single quad: skip it only if no chunk is visible
+	_passTimer->begin(RenderPass::BOARD);
+	if (_nbVisibleChunks > 0) {
+		_boardShader->use();
+		glBindVertexArray(_boardQuadVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glBindVertexArray(0);
+		_boardShader->unuse();
+	}
+	_passTimer->end(RenderPass::BOARD);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/*
+(re)create _boardTexture & the board quad for the current boardSize
+*/
+void NibblerOpenGL::_initBoardTexture() {
+	uint32_t size = _gameInfo->boardSize;
+	_boardCells.assign(size * size, BoardCell::EMPTY);
+	_nextCells.assign(size * size, BoardCell::EMPTY);
+	_paintedCells.clear();
+
+	if (_boardTexture == 0)
+		glGenTextures(1, &_boardTexture);
+	glBindTexture(GL_TEXTURE_2D, _boardTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, _boardCells.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// one quad on the top of the board (cells are centered on integer coordinates)
+	float min = -0.5f;
+	float max = size - 0.5f;
+	float y = 0.5f;
+	float quad[] = {
+		min, y, min,
+		min, y, max,
+		max, y, max,
+
+		min, y, min,
+		max, y, max,
+		max, y, min,
+	};
+	glBindBuffer(GL_ARRAY_BUFFER, _boardQuadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	_boardShader->use();
+	_boardShader->setInt("boardSize", size);
+	_boardShader->unuse();
+	_boardTextureSize = size;
+}
+
+void NibblerOpenGL::_paintCell(int x, int y, uint8_t type) {
+	if (x < 0 || y < 0 || x >= _boardTextureSize || y >= _boardTextureSize)
+		return;
+	uint32_t idx = y * _boardTextureSize + x;
+	_nextCells[idx] = type;
+	_frameCells.push_back(idx);
+}
+
+/*
+build all texts of the HUD in _hudTexts
+this is called only when a value shown in the HUD change
+*/
+void NibblerOpenGL::_buildHud() {
+	_nbHudTexts = 0;
+
+	int x = 20;
+	int y = _gameInfo->realHeight - _textBasicHeight - 10;
+	int lineSz = _textBasicHeight * 1.2;
+	std::string text;
+	if (_gameInfo->nbPlayers == 1) {
+		text = "Score: " + std::to_string(_gameInfo->scores[0]);
+		_addHudText("basicFont", text, x, y, getColor(0, 1));
+		y -= lineSz;
+	}
+	else {
+		for (int id = 0; id < _gameInfo->nbPlayers; id++) {
+			text = "Score ";
+			if (_gameInfo->isIA[id])
+				text += "[IA] ";
+			else if (id == 0)
+				text += "[arrow] ";
+			else
+				text += "[wasd] ";
+			text += std::to_string(id + 1) + " : " + std::to_string(_gameInfo->scores[id]);
+			uint32_t color = (_gameInfo->snakes[id].size() > 0) ? getColor(id, 1) : TEXT_COLOR;
+			_addHudText("basicFont", text, x, y, color);
+			y -= lineSz;
 		}
+	}
+	text = "Best: " + std::to_string(_gameInfo->bestScore);
+	_addHudText("basicFont", text, x, y, 0xFFFFFF);
+
+	y = 10;
+	_addHudText("basicFont", "r: restart", x, y, 0xFFFFFF);
+	y += lineSz;
+	_addHudText("basicFont", "space: pause", x, y, 0xFFFFFF);
+	if (_gameInfo->nbPlayers == 1 || _gameInfo->isIA[1]) {
+		y += lineSz;
+		_addHudText("basicFont", "[wasd]: move camera", x, y, 0xFFFFFF);
 		y += lineSz;
-		_textRender->write("basicFont", "Rshift: bonus player 1", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
+		_addHudText("basicFont", "[ed]: move camera (up-down)", x, y, 0xFFFFFF);
+	}
+	else {
+		y += lineSz;
+		_addHudText("basicFont", "Lshift: bonus player 2", x, y, 0xFFFFFF);
 		y += lineSz;
-		_textRender->write("basicFont", "arrow: move player 1", x, y, 1, TO_OPENGL_COLOR(0xFFFFFF));
+		_addHudText("basicFont", "[wasd]: move player 2", x, y, 0xFFFFFF);
 	}
+	y += lineSz;
+	_addHudText("basicFont", "Rshift: bonus player 1", x, y, 0xFFFFFF);
+	y += lineSz;
+	_addHudText("basicFont", "arrow: move player 1", x, y, 0xFFFFFF);
 
 	if (_gameInfo->win || _gameInfo->gameOver || _gameInfo->paused) {
-		std::string	text;
 		uint32_t	color = TEXT_COLOR;
 
 		if (_gameInfo->win) {
@@ -468,17 +900,39 @@ bool NibblerOpenGL::draw() {
 			text = "Game over";
 			color = TEXT_GAMEOVER_COLOR;
 		}
-		else if (_gameInfo->paused) {
+		else {
 			text = "Pause";
 		}
 		float textX = _gameInfo->realWidth / 2 - _textRender->strWidth("titleFont", text) / 2;
 		float textY = _gameInfo->realHeight / 2 - _textTitleHeight / 2;
-		_textRender->write("titleFont", text, textX, textY, 1, TO_OPENGL_COLOR(color));
+		_addHudText("titleFont", text, textX, textY, color);
 	}
+}
 
-    SDL_GL_SwapWindow(_win);
-	checkError();
-	return true;
+/*
+draw the CPU & GPU time of each render pass (top right, toggled with F3)
+values change every frame -> use the immediate TextRender::write
+*/
+void NibblerOpenGL::_drawPassTimes() {
+	int lineSz = _textBasicHeight * 1.2;
+	int y = _gameInfo->realHeight - _textBasicHeight - 10;
+	std::vector<PassTimer::PassStats> const & stats = _passTimer->getStats();
+	for (auto it = stats.begin(); it != stats.end(); it++) {
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(2) << it->name << " cpu " << it->cpuMs << "ms gpu " << it->gpuMs << "ms";
+		int x = _gameInfo->realWidth - _textRender->strWidth("basicFont", text.str()) - 20;
+		_textRender->write("basicFont", text.str(), x, y, 1, TO_OPENGL_COLOR(TEXT_COLOR));
+		y -= lineSz;
+	}
+}
+
+void NibblerOpenGL::_addHudText(std::string const &fontName, std::string const &str, float x, float y,
+uint32_t color) {
+	if (_nbHudTexts == _hudTexts.size()) {
+		_hudTexts.push_back(TextRender::Text());
+	}
+	_textRender->setText(_hudTexts[_nbHudTexts], fontName, str, x, y, 1, TO_OPENGL_COLOR(color));
+	_nbHudTexts++;
 }
 
 extern "C" {
@@ -0,0 +1,115 @@
+#include "PassTimer.hpp"
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include "Logging.hpp"
+
+PassTimer::PassTimer(std::vector<std::string> const &passNames)
+: _stats(passNames.size()),
+  _queries(PASS_TIMER_RING_SIZE * passNames.size(), 0),
+  _issued(PASS_TIMER_RING_SIZE * passNames.size(), false),
+  _cpuStart(passNames.size()),
+  _frame(0) {
+	for (size_t i = 0; i < passNames.size(); i++) {
+		_stats[i].name = passNames[i];
+	}
+	glGenQueries(_queries.size(), _queries.data());
+}
+
+PassTimer::PassTimer(PassTimer const &src) {
+	*this = src;
+}
+
+PassTimer::~PassTimer() {
+	glDeleteQueries(_queries.size(), _queries.data());
+}
+
+PassTimer &PassTimer::operator=(PassTimer const &rhs) {
+	if (this != &rhs) {
+		_stats = rhs._stats;
+		_queries = rhs._queries;
+		_issued = rhs._issued;
+		_cpuStart = rhs._cpuStart;
+		_frame = rhs._frame;
+	}
+	return *this;
+}
+
+void	PassTimer::begin(uint32_t pass) {
+	_cpuStart[pass] = std::chrono::high_resolution_clock::now();
+	glBeginQuery(GL_TIME_ELAPSED, _queries[_frame * _stats.size() + pass]);
+}
+
+void	PassTimer::end(uint32_t pass) {
+	glEndQuery(GL_TIME_ELAPSED);
+	_issued[_frame * _stats.size() + pass] = true;
+
+	std::chrono::duration<double, std::milli> cpuMs = std::chrono::high_resolution_clock::now() - _cpuStart[pass];
+	PassStats & stats = _stats[pass];
+	stats.cpuMs = (stats.nbCpu == 0) ? cpuMs.count()
+		: stats.cpuMs * (1 - PASS_TIMER_SMOOTHING) + cpuMs.count() * PASS_TIMER_SMOOTHING;
+	stats.totalCpuMs += cpuMs.count();
+	stats.maxCpuMs = std::max(stats.maxCpuMs, cpuMs.count());
+	stats.nbCpu++;
+}
+
+/*
+	go to the next frame of the ring and read the queries issued PASS_TIMER_RING_SIZE frames ago
+*/
+void	PassTimer::endFrame() {
+	_frame = (_frame + 1) % PASS_TIMER_RING_SIZE;
+	_readQueries(_frame);
+}
+
+void	PassTimer::_readQueries(uint32_t frame) {
+	for (size_t pass = 0; pass < _stats.size(); pass++) {
+		size_t id = frame * _stats.size() + pass;
+		if (!_issued[id])
+			continue;
+		_issued[id] = false;
+		GLint available = 0;
+		glGetQueryObjectiv(_queries[id], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;  // still not ready: drop it instead of waiting
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(_queries[id], GL_QUERY_RESULT, &ns);
+
+		double gpuMs = ns / 1000000.0;
+		PassStats & stats = _stats[pass];
+		stats.gpuMs = (stats.nbGpu == 0) ? gpuMs
+			: stats.gpuMs * (1 - PASS_TIMER_SMOOTHING) + gpuMs * PASS_TIMER_SMOOTHING;
+		stats.totalGpuMs += gpuMs;
+		stats.maxGpuMs = std::max(stats.maxGpuMs, gpuMs);
+		stats.nbGpu++;
+	}
+}
+
+std::vector<PassTimer::PassStats> const	&PassTimer::getStats() const { return _stats; }
+
+/*
+	average & max time of each pass (printed on exit)
+*/
+std::string	PassTimer::getReport() const {
+	std::ostringstream	out;
+	out << std::fixed << std::setprecision(3);
+	for (auto it = _stats.begin(); it != _stats.end(); it++) {
+		out << std::endl << "\t" << std::left << std::setw(8) << it->name << std::right
+			<< " cpu avg " << ((it->nbCpu > 0) ? it->totalCpuMs / it->nbCpu : 0) << "ms max " << it->maxCpuMs << "ms"
+			<< " | gpu avg " << ((it->nbGpu > 0) ? it->totalGpuMs / it->nbGpu : 0) << "ms max " << it->maxGpuMs << "ms"
+			<< " (" << it->nbGpu << "/" << it->nbCpu << " frames)";
+	}
+	return out.str();
+}
+
+// -- PassStats ----------------------------------------------------------------
+
+PassTimer::PassStats::PassStats()
+: name(),
+  cpuMs(0),
+  gpuMs(0),
+  totalCpuMs(0),
+  totalGpuMs(0),
+  maxCpuMs(0),
+  maxGpuMs(0),
+  nbCpu(0),
+  nbGpu(0) {}
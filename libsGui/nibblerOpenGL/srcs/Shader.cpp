@@ -1,3 +1,6 @@
+#include <vector>
+#include <functional>
+#include <sys/stat.h>
 #include "Shader.hpp"
 #include "Logging.hpp"
 
@@ -43,6 +46,35 @@ std::string *vsCode, std::string *fsCode, std::string *gsCode
 	}
 }
 
+/*
+	return true if the driver can save & load program binaries
+*/
+bool	isBinaryCacheSupported() {
+	GLint	nbFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nbFormats);
+	return nbFormats > 0;
+}
+
+/*
+	name of the cache file of a program: hash of the sources and of the driver
+	(a driver update invalidate all binaries)
+*/
+std::string	getCacheFilename(std::string const &vsCode, std::string const &fsCode, std::string const &gsCode) {
+	std::string	key = vsCode + '\0' + fsCode + '\0' + gsCode + '\0';
+	char const	*driverInfos[] = {
+		reinterpret_cast<char const *>(glGetString(GL_VENDOR)),
+		reinterpret_cast<char const *>(glGetString(GL_RENDERER)),
+		reinterpret_cast<char const *>(glGetString(GL_VERSION)),
+	};
+	for (auto info : driverInfos) {
+		if (info != nullptr)
+			key += std::string(info) + '\0';
+	}
+	std::stringstream	filename;
+	filename << SHADER_CACHE_DIR << "/" << std::hex << std::hash<std::string>()(key) << ".bin";
+	return filename.str();
+}
+
 Shader::Shader(std::string const vsPath, std::string const fsPath, std::string const gsPath) {
 	std::string	vsCode;
 	std::string	fsCode;
@@ -56,6 +88,17 @@ Shader::Shader(std::string const vsPath, std::string const fsPath, std::string c
 
 	fillShaderStr(vsPath, fsPath, gsPath, &vsCode, &fsCode, &gsCode);
 
+	// try to load the linked program from the cache
+	bool		useCache = isBinaryCacheSupported();
+	std::string	cacheFile;
+	if (useCache) {
+		cacheFile = getCacheFilename(vsCode, fsCode, gsCode);
+		if (_loadBinary(cacheFile)) {
+			_loadUniforms();
+			return;
+		}
+	}
+
 	// vertex shader
 	vsData = vsCode.c_str();
 	vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -81,6 +124,8 @@ Shader::Shader(std::string const vsPath, std::string const fsPath, std::string c
 
 	// shader Program
 	id = glCreateProgram();
+	if (useCache)
+		glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glAttachShader(id, vertex);
 	glAttachShader(id, fragment);
 	if (!gsPath.empty()) {
@@ -88,6 +133,9 @@ Shader::Shader(std::string const vsPath, std::string const fsPath, std::string c
 	}
 	glLinkProgram(id);
 	checkCompileErrors(id, "PROGRAM");
+	_loadUniforms();
+	if (useCache)
+		_saveBinary(cacheFile);
 
 	// delete the shaders as they're linked into our program now and no longer necessery
 	glDeleteShader(vertex);
@@ -107,10 +155,123 @@ Shader::~Shader() {
 Shader &Shader::operator=(Shader const &rhs) {
 	if (this != &rhs) {
 		this->id = rhs.id;
+		_uniforms = rhs._uniforms;
 	}
 	return *this;
 }
 
+// -- program binary cache -----------------------------------------------------
+
+/*
+	create the program from a cache file
+	return false (and no program) if the file doesn't exist or is refused by the driver
+*/
+bool	Shader::_loadBinary(std::string const &cacheFile) {
+	std::ifstream	file(cacheFile, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	uint32_t	magic = 0;
+	GLenum		format = 0;
+	file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char *>(&format), sizeof(format));
+	if (!file.good() || magic != SHADER_CACHE_MAGIC) {
+		logWarn("invalid shader cache " << cacheFile);
+		return false;
+	}
+	std::vector<char>	binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (binary.empty()) {
+		logWarn("invalid shader cache " << cacheFile);
+		return false;
+	}
+
+	id = glCreateProgram();
+	glProgramBinary(id, format, binary.data(), binary.size());
+	GLint	success = 0;
+	glGetProgramiv(id, GL_LINK_STATUS, &success);
+	if (!success) {
+		logWarn("shader cache " << cacheFile << " refused by the driver, compile from sources");
+		glDeleteProgram(id);
+		id = 0;
+		return false;
+	}
+	logDebug("shader loaded from cache " << cacheFile);
+	return true;
+}
+
+/*
+	save the linked program in a cache file (errors are only warnings, the cache is optional)
+*/
+void	Shader::_saveBinary(std::string const &cacheFile) {
+	GLint	length = 0;
+	glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char>	binary(length);
+	GLenum				format = 0;
+	glGetProgramBinary(id, length, NULL, &format, binary.data());
+
+	mkdir(SHADER_CACHE_DIR, 0755);
+	std::ofstream	file(cacheFile, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		logWarn("unable to write shader cache " << cacheFile);
+		return;
+	}
+	uint32_t	magic = SHADER_CACHE_MAGIC;
+	file.write(reinterpret_cast<char const *>(&magic), sizeof(magic));
+	file.write(reinterpret_cast<char const *>(&format), sizeof(format));
+	file.write(binary.data(), binary.size());
+	if (!file.good())
+		logWarn("unable to write shader cache " << cacheFile);
+}
+
+/*
+	save the location of all active uniforms (called once after linking)
+*/
+void	Shader::_loadUniforms() {
+	GLint	nbUniforms = 0;
+	GLint	maxLength = 0;
+
+	_uniforms.clear();
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &nbUniforms);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar>	name(maxLength + 1, 0);
+	for (GLint i = 0; i < nbUniforms; i++) {
+		GLsizei	length = 0;
+		GLint	size = 0;
+		GLenum	type = 0;
+		glGetActiveUniform(id, i, maxLength, &length, &size, &type, name.data());
+		GLint location = glGetUniformLocation(id, name.data());
+		if (location < 0)
+			continue;  // uniform inside a block
+		std::string uniformName(name.data(), length);
+		_uniforms[uniformName] = location;
+		// arrays are named "name[0]", save also "name"
+		if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+			_uniforms[uniformName.substr(0, uniformName.size() - 3)] = location;
+	}
+}
+
+GLint	Shader::getUniformLocation(std::string const &name) const {
+	auto it = _uniforms.find(name);
+	if (it == _uniforms.end())
+		return -1;
+	return it->second;
+}
+
+/*
+	link the uniform block blockName to the UniformBuffer bound on bindingPoint
+*/
+bool	Shader::bindUniformBlock(std::string const &blockName, GLuint bindingPoint) {
+	GLuint index = glGetUniformBlockIndex(id, blockName.c_str());
+	if (index == GL_INVALID_INDEX) {
+		logWarn("uniform block " << blockName << " not found in shader");
+		return false;
+	}
+	glUniformBlockBinding(id, index, bindingPoint);
+	return true;
+}
+
 void	Shader::use() {
 	glUseProgram(id);
 }
@@ -118,65 +279,91 @@ void	Shader::unuse() {
 	glUseProgram(0);
 }
 void	Shader::setBool(const std::string &name, bool value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), static_cast<int>(value));
+	glUniform1i(getUniformLocation(name), static_cast<int>(value));
 }
 void	Shader::setInt(const std::string &name, int value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1i(getUniformLocation(name), value);
 }
 void	Shader::setFloat(const std::string &name, float value) const {
-	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1f(getUniformLocation(name), value);
 }
 void	Shader::setDouble(const std::string &name, double value) const {
-	glUniform1d(glGetUniformLocation(id, name.c_str()), value);
+	glUniform1d(getUniformLocation(name), value);
 }
 // ------------------------------------------------------------------------
 void	Shader::setVec2(const std::string &name, float x, float y) const {
-	glUniform2f(glGetUniformLocation(id, name.c_str()), x, y);
+	glUniform2f(getUniformLocation(name), x, y);
 }
 void	Shader::setVec2(const std::string &name, const glm::vec2 &vec) const {
-	glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform2fv(getUniformLocation(name), 1, &vec[0]);
 }
 void	Shader::setVec2Double(const std::string &name, double x, double y) const {
-	glUniform2d(glGetUniformLocation(id, name.c_str()), x, y);
+	glUniform2d(getUniformLocation(name), x, y);
 }
 void	Shader::setVec2Double(const std::string &name, const glm::tvec2<double> &vec) const {
-	glUniform2dv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform2dv(getUniformLocation(name), 1, &vec[0]);
 }
 // ------------------------------------------------------------------------
 void	Shader::setVec3(const std::string &name, float x, float y, float z) const {
-	glUniform3f(glGetUniformLocation(id, name.c_str()), x, y, z);
+	glUniform3f(getUniformLocation(name), x, y, z);
 }
 void	Shader::setVec3(const std::string &name, const glm::vec3 &vec) const {
-	glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform3fv(getUniformLocation(name), 1, &vec[0]);
 }
 void	Shader::setVec3Double(const std::string &name, double x, double y, double z) const {
-	glUniform3d(glGetUniformLocation(id, name.c_str()), x, y, z);
+	glUniform3d(getUniformLocation(name), x, y, z);
 }
 void	Shader::setVec3Double(const std::string &name, const glm::tvec3<double> &vec) const {
-	glUniform3dv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform3dv(getUniformLocation(name), 1, &vec[0]);
 }
 // ------------------------------------------------------------------------
 void	Shader::setVec4(const std::string &name, float x, float y, float z, float w) const {
-	glUniform4f(glGetUniformLocation(id, name.c_str()), x, y, z, w);
+	glUniform4f(getUniformLocation(name), x, y, z, w);
 }
 void	Shader::setVec4(const std::string &name, const glm::vec4 &vec) const {
-	glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform4fv(getUniformLocation(name), 1, &vec[0]);
 }
 void	Shader::setVec4Double(const std::string &name, double x, double y, double z, double w) const {
-	glUniform4d(glGetUniformLocation(id, name.c_str()), x, y, z, w);
+	glUniform4d(getUniformLocation(name), x, y, z, w);
 }
 void	Shader::setVec4Double(const std::string &name, const glm::tvec4<double> &vec) const {
-	glUniform4dv(glGetUniformLocation(id, name.c_str()), 1, &vec[0]);
+	glUniform4dv(getUniformLocation(name), 1, &vec[0]);
 }
 // ------------------------------------------------------------------------
 void	Shader::setMat2(const std::string &name, const glm::mat2 &mat) const {
-	glUniformMatrix2fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 void	Shader::setMat3(const std::string &name, const glm::mat3 &mat) const {
-	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 void	Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+}
+
+// -- typed handles -------------------------------------------------------
+void	Shader::set(Uniform<bool> const &uniform, bool value) const {
+	glUniform1i(uniform.location, static_cast<int>(value));
+}
+void	Shader::set(Uniform<int> const &uniform, int value) const {
+	glUniform1i(uniform.location, value);
+}
+void	Shader::set(Uniform<float> const &uniform, float value) const {
+	glUniform1f(uniform.location, value);
+}
+void	Shader::set(Uniform<glm::vec2> const &uniform, const glm::vec2 &vec) const {
+	glUniform2fv(uniform.location, 1, &vec[0]);
+}
+void	Shader::set(Uniform<glm::vec3> const &uniform, const glm::vec3 &vec) const {
+	glUniform3fv(uniform.location, 1, &vec[0]);
+}
+void	Shader::set(Uniform<glm::vec4> const &uniform, const glm::vec4 &vec) const {
+	glUniform4fv(uniform.location, 1, &vec[0]);
+}
+void	Shader::set(Uniform<glm::mat3> const &uniform, const glm::mat3 &mat) const {
+	glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+}
+void	Shader::set(Uniform<glm::mat4> const &uniform, const glm::mat4 &mat) const {
+	glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
 }
 
 /*
@@ -48,17 +48,25 @@ const float Skybox::_vertices[] = {
 };
 
 Skybox::Skybox() :
-_shader(SHADER_SKYBOX_VS, SHADER_SKYBOX_FS) {
-	std::vector<std::string> skyboxFaces = {
-		std::string(SKYBOX_START) + SKYBOX_NAME_RIGHT + SKYBOX_EXT,  // right
-		std::string(SKYBOX_START) + SKYBOX_NAME_LEFT + SKYBOX_EXT,  // left
-		std::string(SKYBOX_START) + SKYBOX_NAME_TOP + SKYBOX_EXT,  // up
-		std::string(SKYBOX_START) + SKYBOX_NAME_BOTTOM + SKYBOX_EXT,  // down
-		std::string(SKYBOX_START) + SKYBOX_NAME_FRONT + SKYBOX_EXT,  // front
-		std::string(SKYBOX_START) + SKYBOX_NAME_BACK + SKYBOX_EXT,  // back
-	};
+_shader(SHADER_SKYBOX_VS, SHADER_SKYBOX_FS),
+_nightProgressUniform(_shader.getUniform<float>("nightProgress")) {
+	std::vector<std::future<Image> > faces = decodeFacesAsync(getDefaultFaces());
+	_init(faces);
+}
+
+/*
+create the skybox from faces already decoding (decodeFacesAsync)
+*/
+Skybox::Skybox(std::vector<std::future<Image> > &faces) :
+_shader(SHADER_SKYBOX_VS, SHADER_SKYBOX_FS),
+_nightProgressUniform(_shader.getUniform<float>("nightProgress")) {
+	_init(faces);
+}
+
+void Skybox::_init(std::vector<std::future<Image> > &faces) {
+	_shader.bindUniformBlock(PER_FRAME_UBO_NAME, PER_FRAME_UBO_BINDING);
 	_shader.use();
-	load(skyboxFaces);
+	load(faces);
 
 	_vao = 0;
 	_vbo = 0;
@@ -96,13 +104,54 @@ Skybox::~Skybox() {
 Skybox &Skybox::operator=(Skybox const &rhs) {
 	if (this != &rhs) {
 		_textureID = getTextureID();
+		_nightProgressUniform = rhs._nightProgressUniform;
 		_vao = rhs._vao;
 		_vbo = rhs._vbo;
 	}
 	return *this;
 }
 
+std::vector<std::string> Skybox::getDefaultFaces() {
+	return std::vector<std::string> {
+		std::string(SKYBOX_START) + SKYBOX_NAME_RIGHT + SKYBOX_EXT,  // right
+		std::string(SKYBOX_START) + SKYBOX_NAME_LEFT + SKYBOX_EXT,  // left
+		std::string(SKYBOX_START) + SKYBOX_NAME_TOP + SKYBOX_EXT,  // up
+		std::string(SKYBOX_START) + SKYBOX_NAME_BOTTOM + SKYBOX_EXT,  // down
+		std::string(SKYBOX_START) + SKYBOX_NAME_FRONT + SKYBOX_EXT,  // front
+		std::string(SKYBOX_START) + SKYBOX_NAME_BACK + SKYBOX_EXT,  // back
+	};
+}
+
+/*
+decode a face with stb_image (cpu only)
+*/
+Skybox::Image Skybox::decodeFace(std::string const &path) {
+	Image	image;
+	image.path = path;
+	image.data.reset(stbi_load(path.c_str(), &image.width, &image.height, &image.nrChannels, 0));
+	return image;
+}
+
+/*
+start to decode each face on its own thread, the GL upload is done later with load
+*/
+std::vector<std::future<Skybox::Image> > Skybox::decodeFacesAsync(std::vector<std::string> const &faces) {
+	std::vector<std::future<Image> > res;
+	for (auto it = faces.begin(); it != faces.end(); it++) {
+		res.push_back(std::async(std::launch::async, &Skybox::decodeFace, *it));
+	}
+	return res;
+}
+
 void Skybox::load(std::vector<std::string> &faces) {
+	std::vector<std::future<Image> > decodedFaces = decodeFacesAsync(faces);
+	load(decodedFaces);
+}
+
+/*
+upload the faces in the cubemap, wait for each face to be decoded
+*/
+void Skybox::load(std::vector<std::future<Image> > &faces) {
     glGenTextures(1, &_textureID);
 	glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, _textureID);
@@ -115,32 +164,28 @@ void Skybox::load(std::vector<std::string> &faces) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BASE_LEVEL, 0);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
 
-    int width;
-	int height;
-	int nrChannels;
     for (unsigned int i = 0; i < faces.size(); ++i) {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-			if ((width & (width - 1)) != 0 || (height & (height - 1)) != 0) {
-				logErr("image " << faces[i] << " is not power-of-2 dimensions");
+		Image image = faces[i].get();
+        if (image.data) {
+			if ((image.width & (image.width - 1)) != 0 || (image.height & (image.height - 1)) != 0) {
+				logErr("image " << image.path << " is not power-of-2 dimensions");
 			}
 			GLenum format = GL_RGB;
-			if (nrChannels == 1) {
+			if (image.nrChannels == 1) {
 				format = GL_RED;
 			}
-			else if (nrChannels == 3) {
+			else if (image.nrChannels == 3) {
 				format = GL_RGB;
 			}
-			else if (nrChannels == 4) {
+			else if (image.nrChannels == 4) {
 				format = GL_RGBA;
 			}
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                         0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
+                         0, static_cast<GLint>(format), image.width, image.height, 0, format, GL_UNSIGNED_BYTE,
+						 image.data.get());
         }
         else {
-            logErr("Skyboox texture failed to load at path: " << faces[i]);
-            stbi_image_free(data);
+            logErr("Skyboox texture failed to load at path: " << image.path);
         }
     }
 
@@ -153,7 +198,7 @@ void Skybox::draw(float nightProgress) {
 	glBindVertexArray(_vao);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, _textureID);
-	_shader.setFloat("nightProgress", nightProgress);
+	_shader.set(_nightProgressUniform, nightProgress);
 	glDrawArrays(GL_TRIANGLES, 0, sizeof(_vertices) / sizeof(_vertices[0]));
 	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 	glDepthFunc(GL_LESS);
@@ -161,6 +206,15 @@ void Skybox::draw(float nightProgress) {
 	_shader.unuse();
 }
 
+// -- Image --------------------------------------------------------------------
+
+Skybox::Image::Image()
+: path(),
+  width(0),
+  height(0),
+  nrChannels(0),
+  data(nullptr, stbi_image_free) {}
+
 Shader			&Skybox::getShader() { return _shader; }
 Shader const	&Skybox::getShader() const { return _shader; }
 uint32_t		Skybox::getTextureID() const { return _textureID; }
@@ -1,9 +1,11 @@
 #include "TextRender.hpp"
+#include <algorithm>
 #include "debug.hpp"
 #include "Logging.hpp"
 
 TextRender::TextRender(uint32_t width, uint32_t height) :
 _shader(SHADER_TEXT_VS, SHADER_TEXT_FS),
+_textColorUniform(_shader.getUniform<glm::vec3>("textColor")),
 _projection(glm::ortho(0.0f, static_cast<GLfloat>(width), 0.0f, static_cast<GLfloat>(height))) {
 	// create VAO & VBO
 	_vao = 0;
@@ -19,11 +21,23 @@ _projection(glm::ortho(0.0f, static_cast<GLfloat>(width), 0.0f, static_cast<GLfl
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	_shader.setMat4("projection", _projection);
 	_shader.unuse();
+	_shader.bindUniformBlock(PER_FRAME_UBO_NAME, PER_FRAME_UBO_BINDING);
 }
 
+/*
+load the ascii glyphs of a font and pack them in a single atlas texture (rasterize + upload)
+*/
 void TextRender::loadFont(std::string name, std::string const &filename, uint32_t size) {
+	loadFont(name, rasterizeFont(filename, size));
+}
+
+/*
+rasterize the ascii glyphs of a font and pack them in an atlas (cpu only)
+glyphs are placed on rows of TEXT_ATLAS_WIDTH pixels
+this doesn't use OpenGL -> it can run on a worker thread (each call use its own FT_Library)
+*/
+TextRender::GlyphSet TextRender::rasterizeFont(std::string const &filename, uint32_t size) {
 	FT_Library ft;
 	if (FT_Init_FreeType(&ft)) {
 		logErr("Could not init FreeType Library");
@@ -37,42 +51,90 @@ void TextRender::loadFont(std::string name, std::string const &filename, uint32_
 	}
 	FT_Set_Pixel_Sizes(face, 0, size);  // set size
 
-	font.insert(std::pair<std::string, std::map<GLchar, Character> >(name, std::map<GLchar, Character>()));
-
-
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	for (GLubyte c = 0; c < 128; c++) {
+	GlyphSet	glyphs;
+	Font &		newFont = glyphs.font;
+	std::vector<uint8_t>	bitmaps[TEXT_NB_CHARS];  // bitmap of each char (width * rows)
+	glm::ivec2				atlasPos[TEXT_NB_CHARS];
+	uint32_t	penX = TEXT_ATLAS_PADDING;
+	uint32_t	penY = TEXT_ATLAS_PADDING;
+	uint32_t	rowHeight = 0;
+	for (GLubyte c = 0; c < TEXT_NB_CHARS; c++) {
 		// load char
 		if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
 			logErr("Failed to load char: " << c << " in " << filename);
 			continue;
 		}
-		// generate texture
-		GLuint texture;
-		glGenTextures(1, &texture);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, 0,
-			GL_RED, GL_UNSIGNED_BYTE, face->glyph->bitmap.buffer);
-		// set textures options
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		FT_Bitmap const & bitmap = face->glyph->bitmap;
+		// copy the bitmap (FreeType reuse the glyph slot for the next char)
+		bitmaps[c].resize(bitmap.width * bitmap.rows);
+		for (uint32_t row = 0; row < bitmap.rows; row++) {
+			std::copy(bitmap.buffer + row * bitmap.pitch, bitmap.buffer + row * bitmap.pitch + bitmap.width,
+				bitmaps[c].begin() + row * bitmap.width);
+		}
+		// find a place in the atlas
+		if (penX + bitmap.width + TEXT_ATLAS_PADDING > TEXT_ATLAS_WIDTH) {
+			penX = TEXT_ATLAS_PADDING;
+			penY += rowHeight + TEXT_ATLAS_PADDING;
+			rowHeight = 0;
+		}
+		atlasPos[c] = glm::ivec2(penX, penY);
+		penX += bitmap.width + TEXT_ATLAS_PADDING;
+		rowHeight = std::max(rowHeight, static_cast<uint32_t>(bitmap.rows));
 		// save char args for future write
-		Character character = {
-			texture,
-			glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-			glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-			face->glyph->advance.x
-		};
-		font[name].insert(std::pair<GLchar, Character>(c, character));
-		glBindTexture(GL_TEXTURE_2D, 0);
+		newFont.chars[c].size = glm::ivec2(bitmap.width, bitmap.rows);
+		newFont.chars[c].bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+		newFont.chars[c].advance = face->glyph->advance.x;
 	}
+	glyphs.atlasHeight = penY + rowHeight + TEXT_ATLAS_PADDING;
+	uint32_t	atlasHeight = glyphs.atlasHeight;
 
 	// delete freetype objects
 	FT_Done_Face(face);
 	FT_Done_FreeType(ft);
+
+	// fill the atlas
+	std::vector<uint8_t> &	atlas = glyphs.atlas;
+	atlas.assign(TEXT_ATLAS_WIDTH * atlasHeight, 0);
+	for (GLubyte c = 0; c < TEXT_NB_CHARS; c++) {
+		Character & ch = newFont.chars[c];
+		for (int32_t row = 0; row < ch.size.y; row++) {
+			std::copy(bitmaps[c].begin() + row * ch.size.x, bitmaps[c].begin() + (row + 1) * ch.size.x,
+				atlas.begin() + (atlasPos[c].y + row) * TEXT_ATLAS_WIDTH + atlasPos[c].x);
+		}
+		ch.uvMin = glm::vec2(static_cast<float>(atlasPos[c].x) / TEXT_ATLAS_WIDTH,
+			static_cast<float>(atlasPos[c].y) / atlasHeight);
+		ch.uvMax = glm::vec2(static_cast<float>(atlasPos[c].x + ch.size.x) / TEXT_ATLAS_WIDTH,
+			static_cast<float>(atlasPos[c].y + ch.size.y) / atlasHeight);
+	}
+
+	return glyphs;
+}
+
+/*
+upload the atlas of a rasterized font (render thread)
+*/
+void TextRender::loadFont(std::string name, GlyphSet const &glyphs) {
+	Font	newFont = glyphs.font;
+
+	// generate texture
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glGenTextures(1, &newFont.textureID);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, newFont.textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, TEXT_ATLAS_WIDTH, glyphs.atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE,
+		glyphs.atlas.data());
+	// set textures options
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// replace the font if it was already loaded
+	if (font.find(name) != font.end() && font[name].textureID != 0) {
+		glDeleteTextures(1, &font[name].textureID);
+	}
+	font[name] = newFont;
 }
 
 
@@ -88,8 +150,8 @@ TextRender::~TextRender() {
 	glDeleteBuffers(1, &_vbo);
 
 	for (auto const & elem : font) {
-		if (elem.second.size() > 0 && elem.second.begin()->second.textureID != 0) {
-			glDeleteTextures(1, &elem.second.begin()->second.textureID);
+		if (elem.second.textureID != 0) {
+			glDeleteTextures(1, &elem.second.textureID);
 		}
 	}
     _shader.unuse();
@@ -98,66 +160,182 @@ TextRender::~TextRender() {
 TextRender &TextRender::operator=(TextRender const &rhs) {
 	(void)rhs;
 	if (this != &rhs) {
+		_textColorUniform = rhs._textColorUniform;
+		_projection = rhs._projection;
 		_vao = rhs._vao;
 		_vbo = rhs._vbo;
 	}
 	return *this;
 }
 
+/*
+layout the string in vertices (6 vertices per char, using the font atlas)
+return the width of the string
+*/
+uint32_t TextRender::_buildVertices(Font const &f, std::string const &str, GLfloat x, GLfloat y, GLfloat scale,
+std::vector<GLfloat> &vertices) const {
+	uint32_t	width = 0;
+	vertices.reserve(vertices.size() + str.size() * 6 * SHADER_TEXT_ROW_SIZE);
+	for (auto c = str.begin(); c != str.end(); c++) {  // foreach chars
+		uint8_t code = static_cast<uint8_t>(*c);
+		if (code >= TEXT_NB_CHARS)
+			continue;
+		Character const & ch = f.chars[code];
+		GLfloat xpos = x + ch.bearing.x * scale;
+		GLfloat ypos = y - (ch.size.y - ch.bearing.y) * scale;
+		GLfloat w = ch.size.x * scale;
+		GLfloat h = ch.size.y * scale;
+		GLfloat charVertices[6][SHADER_TEXT_ROW_SIZE] = {
+			{xpos,     ypos + h,   ch.uvMin.x, ch.uvMin.y},
+			{xpos,     ypos,       ch.uvMin.x, ch.uvMax.y},
+			{xpos + w, ypos,       ch.uvMax.x, ch.uvMax.y},
+			{xpos,     ypos + h,   ch.uvMin.x, ch.uvMin.y},
+			{xpos + w, ypos,       ch.uvMax.x, ch.uvMax.y},
+			{xpos + w, ypos + h,   ch.uvMax.x, ch.uvMin.y},
+		};
+		vertices.insert(vertices.end(), &charVertices[0][0], &charVertices[0][0] + 6 * SHADER_TEXT_ROW_SIZE);
+		// move cursor to the next character
+		x += (ch.advance >> 6) * scale;
+		width += (ch.advance >> 6) * scale;
+	}
+	return width;
+}
+
+/*
+immediate write: layout the string, upload it in the shared VBO and draw it in one call
+prefer setText + draw for texts that doesn't change every frame
+*/
 void TextRender::write(std::string const &fontName, std::string text, GLfloat x, GLfloat y,
 GLfloat scale, glm::vec3 color) {
-	if (font.find(fontName) == font.end()) {
+	auto it = font.find(fontName);
+	if (it == font.end()) {
 		logErr("invalid font name " << fontName);
 		return;
 	}
-    _shader.use();
-    _shader.setVec3("textColor", color);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(_vao);
-	for (auto c = text.begin(); c != text.end(); c++) {  // foreach chars
-        Character ch = font[fontName][*c];
-        GLfloat xpos = x + ch.bearing.x * scale;
-        GLfloat ypos = y - (ch.size.y - ch.bearing.y) * scale;
-        GLfloat w = ch.size.x * scale;
-        GLfloat h = ch.size.y * scale;
-        // set VBO values
-        GLfloat vertices[6][SHADER_TEXT_ROW_SIZE] = {
-            {xpos,     ypos + h,   0.0, 0.0},
-            {xpos,     ypos,       0.0, 1.0},
-            {xpos + w, ypos,       1.0, 1.0},
-            {xpos,     ypos + h,   0.0, 0.0},
-            {xpos + w, ypos,       1.0, 1.0},
-            {xpos + w, ypos + h,   1.0, 0.0},
-		   };
-        // bind char texture
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
-        // set VBO on shader
-        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // draw char
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindTexture(GL_TEXTURE_2D, 0);
-        // move cursor to the next character
-        x += (ch.advance >> 6) * scale;
-    }
-    glBindVertexArray(0);
-    _shader.unuse();
+	std::vector<GLfloat> vertices;
+	_buildVertices(it->second, text, x, y, scale, vertices);
+	if (vertices.empty())
+		return;
+
+	_shader.use();
+	_shader.set(_textColorUniform, color);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, it->second.textureID);
+	glBindVertexArray(_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDrawArrays(GL_TRIANGLES, 0, vertices.size() / SHADER_TEXT_ROW_SIZE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	_shader.unuse();
 }
 
 uint32_t	TextRender::strWidth(std::string const &fontName, std::string text, GLfloat scale) {
 	uint32_t	width = 0;
-	if (font.find(fontName) == font.end()) {
+	auto it = font.find(fontName);
+	if (it == font.end()) {
 		logErr("invalid font name " << fontName);
 		return 0;
 	}
 	for (auto c = text.begin(); c != text.end(); c++) {  // foreach chars
-        Character ch = font[fontName][*c];
-        width += (ch.advance >> 6) * scale;
-    }
+		uint8_t code = static_cast<uint8_t>(*c);
+		if (code >= TEXT_NB_CHARS)
+			continue;
+		width += (it->second.chars[code].advance >> 6) * scale;
+	}
 	return width;
 }
 
+// -- Font ---------------------------------------------------------------------
+
+TextRender::Font::Font()
+: textureID(0) {
+	for (uint32_t i = 0; i < TEXT_NB_CHARS; i++) {
+		chars[i].size = glm::ivec2(0, 0);
+		chars[i].bearing = glm::ivec2(0, 0);
+		chars[i].advance = 0;
+		chars[i].uvMin = glm::vec2(0, 0);
+		chars[i].uvMax = glm::vec2(0, 0);
+	}
+}
+
+// -- GlyphSet -----------------------------------------------------------------
+
+TextRender::GlyphSet::GlyphSet()
+: font(),
+  atlasHeight(0),
+  atlas() {}
+
+// -- Text ---------------------------------------------------------------------
+
+TextRender::Text::Text()
+: vao(0),
+  vbo(0),
+  texture(0),
+  nbVertices(0),
+  color(1.0f, 1.0f, 1.0f),
+  width(0) {}
+
+/*
+layout the string and upload all chars in the Text VBO
+*/
+void TextRender::setText(Text &text, std::string const &fontName, std::string const &str, GLfloat x, GLfloat y,
+GLfloat scale, glm::vec3 color) {
+	auto it = font.find(fontName);
+	if (it == font.end()) {
+		logErr("invalid font name " << fontName);
+		return;
+	}
+	std::vector<GLfloat> vertices;
+	text.width = _buildVertices(it->second, str, x, y, scale, vertices);
+	text.texture = it->second.textureID;
+	text.nbVertices = vertices.size() / SHADER_TEXT_ROW_SIZE;
+	text.color = color;
+
+	if (text.vao == 0) {
+		glGenVertexArrays(1, &text.vao);
+		glGenBuffers(1, &text.vbo);
+		glBindVertexArray(text.vao);
+		glBindBuffer(GL_ARRAY_BUFFER, text.vbo);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, SHADER_TEXT_ROW_SIZE * sizeof(GLfloat), 0);
+		glBindVertexArray(0);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, text.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(), vertices.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+draw a Text built with setText (no layout & no upload, one draw call)
+*/
+void TextRender::draw(Text const &text) {
+	if (text.vao == 0 || text.nbVertices == 0)
+		return;
+	_shader.use();
+	_shader.set(_textColorUniform, text.color);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, text.texture);
+	glBindVertexArray(text.vao);
+	glDrawArrays(GL_TRIANGLES, 0, text.nbVertices);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	_shader.unuse();
+}
+
+void TextRender::deleteText(Text &text) {
+	if (text.vao != 0) {
+		glDeleteVertexArrays(1, &text.vao);
+		glDeleteBuffers(1, &text.vbo);
+	}
+	text.vao = 0;
+	text.vbo = 0;
+	text.texture = 0;
+	text.nbVertices = 0;
+	text.width = 0;
+}
 
 Shader			&TextRender::getShader() { return _shader; }
 Shader const	&TextRender::getShader() const { return _shader; }
+glm::mat4 const	&TextRender::getProjection() const { return _projection; }
@@ -0,0 +1,34 @@
+#include "UniformBuffer.hpp"
+#include "Logging.hpp"
+
+UniformBuffer::UniformBuffer(GLuint bindingPoint, GLsizeiptr size)
+: _id(0),
+  _bindingPoint(bindingPoint),
+  _size(size) {
+	glGenBuffers(1, &_id);
+	glBindBuffer(GL_UNIFORM_BUFFER, _id);
+	glBufferData(GL_UNIFORM_BUFFER, _size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _id);
+}
+
+UniformBuffer::~UniformBuffer() {
+	glDeleteBuffers(1, &_id);
+}
+
+/*
+	upload data in the buffer (call it once per frame)
+*/
+void	UniformBuffer::update(void const *data, GLsizeiptr size, GLintptr offset) {
+	if (offset + size > _size) {
+		logErr("UniformBuffer: update out of range (" << offset + size << " > " << _size << ")");
+		return;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, _id);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLuint		UniformBuffer::getID() const { return _id; }
+GLuint		UniformBuffer::getBindingPoint() const { return _bindingPoint; }
+GLsizeiptr	UniformBuffer::getSize() const { return _size; }
@@ -23,6 +23,8 @@ GLenum checkError_(const char *file, int line) {
 
 void checkErrorExit_(const char *file, int line) {
     GLenum ret = checkError_(file, line);
-    if (ret != GL_NO_ERROR)
+    if (ret != GL_NO_ERROR) {
+        logging.flush();
         exit(1);
+    }
 }
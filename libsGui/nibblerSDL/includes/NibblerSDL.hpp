@@ -15,6 +15,7 @@ class NibblerSDL : public ANibblerGui {
 
 		virtual void	updateInput();
 		virtual bool	draw();
+		virtual void	waitInput(uint32_t timeoutUs);
 
 	private:
 		SDL_Window *	_win;
@@ -22,4 +23,5 @@ class NibblerSDL : public ANibblerGui {
 		SDL_Event *		_event;
 
 		virtual bool	_init();
+		virtual void	_setActive(bool active);
 };
@@ -1,5 +1,6 @@
 #include "NibblerSDL.hpp"
 #include "Logging.hpp"
+#include "Tracer.hpp"
 
 NibblerSDL::NibblerSDL() :
   _win(nullptr),
@@ -19,7 +20,7 @@ NibblerSDL::~NibblerSDL() {
 	logInfo("exit SDL");
 	delete _event;
 	SDL_DestroyWindow(_win);
-    SDL_Quit();
+	SDL_QuitSubSystem(SDL_INIT_VIDEO);  // other resident libs can still use SDL
 }
 
 NibblerSDL::NibblerSDL(NibblerSDL const &src) {
@@ -36,32 +37,46 @@ NibblerSDL &NibblerSDL::operator=(NibblerSDL const &rhs) {
 bool NibblerSDL::_init() {
 	logInfo("loading SDL");
 
+	uint64_t phaseStart = (_tracer != nullptr) ? _tracer->begin() : 0;
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         logErr("while loading SDL: " << SDL_GetError());
-        SDL_Quit();
 		return false;
     }
+	if (_tracer != nullptr)
+		phaseStart = _tracer->end("SDL_Init video", phaseStart);
 
 	_win = SDL_CreateWindow((_gameInfo->title + " SDL").c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
 		_gameInfo->realWidth, _gameInfo->realHeight, SDL_WINDOW_SHOWN);
 	if (_win == nullptr) {
         logErr("while loading SDL: " << SDL_GetError());
-		SDL_Quit();
 		return false;
 	}
 
 	_surface = SDL_GetWindowSurface(_win);
 	if (_surface == nullptr) {
         logErr("while loading SDL: " << SDL_GetError());
-		SDL_Quit();
 		return false;
 	}
+	if (_tracer != nullptr)
+		_tracer->end("create window", phaseStart);
 
     return true;
 }
 
+void NibblerSDL::_setActive(bool active) {
+	if (active) {
+		SDL_ShowWindow(_win);
+		SDL_RaiseWindow(_win);
+	}
+	else {
+		SDL_HideWindow(_win);
+	}
+}
+
 void NibblerSDL::updateInput() {
 	while (SDL_PollEvent(_event)) {
+		if (_event->type == SDL_WINDOWEVENT)
+			_needRedraw = true;  // exposed, resized...
 		if (_event->window.event == SDL_WINDOWEVENT_CLOSE)
 			input.quit = true;
 
@@ -73,6 +88,8 @@ void NibblerSDL::updateInput() {
 				input.paused = !input.paused;
 			else if (_event->key.keysym.sym == SDLK_r)
 				input.restart = true;
+			else if (_event->key.keysym.sym == SDLK_F12)
+				input.saveTrace = true;
 
 			// move player 1
 			else if (_event->key.keysym.sym == SDLK_UP)
@@ -119,7 +136,26 @@ void NibblerSDL::updateInput() {
 	}
 }
 
+/*
+block on the event queue until the end of the frame: only the events handled by updateInput (key down, window)
+wake up the game loop, the others (mouse motion, key up...) are dropped and the wait continue
+*/
+void NibblerSDL::waitInput(uint32_t timeoutUs) {
+	Uint32 end = SDL_GetTicks() + timeoutUs / 1000;
+	while (true) {
+		Uint32 now = SDL_GetTicks();
+		if (static_cast<int32_t>(end - now) <= 0)
+			return;
+		if (SDL_WaitEventTimeout(NULL, end - now) == 0)  // NULL: the event stays in the queue for updateInput
+			return;
+		if (SDL_HasEvent(SDL_QUIT) || SDL_HasEvent(SDL_WINDOWEVENT) || SDL_HasEvent(SDL_KEYDOWN))
+			return;
+		SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);  // the keyboard state is already updated
+	}
+}
+
 bool NibblerSDL::draw() {
+	TRACE_SCOPE(_tracer, "NibblerSDL::draw");
 	// clear screen
 	SDL_FillRect(_surface, NULL, 0x000000);
 
@@ -21,6 +21,16 @@ class NibblerSFML : public ANibblerGui {
 		sf::RenderWindow	_win;
 		sf::Event			_event;
 		sf::Font			_font;
+		sf::VertexArray		_boardVertices;  // border + board squares, rebuilt only if boardSize change
+		sf::VertexArray		_entitiesVertices;  // snakes, wall, food & bonus, rebuilt each frame
+		uint8_t				_boardVerticesSize;  // boardSize used to build _boardVertices
+		HudState			_hudState;  // values shown in _hudTexts
+		std::vector<sf::Text>	_hudTexts;  // HUD texts, re-layout only if _hudState change
 
 		virtual bool	_init();
+		virtual void	_setActive(bool active);
+		void			_buildBoard(float size, float step);
+		void			_buildHud(float size);
+		void			_addHudText(std::string const & str, float x, float y, float textSize, uint32_t color);
+		static void		_addQuad(sf::VertexArray & vertices, float x, float y, float size, uint32_t color);
 };
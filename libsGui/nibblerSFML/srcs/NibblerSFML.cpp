@@ -1,8 +1,13 @@
+#include <future>
 #include "NibblerSFML.hpp"
 #include "Logging.hpp"
+#include "Tracer.hpp"
 
 NibblerSFML::NibblerSFML() :
-  _win() {
+  _win(),
+  _boardVertices(sf::Quads),
+  _entitiesVertices(sf::Quads),
+  _boardVerticesSize(0) {
 	// init logging
 	#if DEBUG
 		logging.setLoglevel(LOGDEBUG);
@@ -33,9 +38,17 @@ NibblerSFML &NibblerSFML::operator=(NibblerSFML const &rhs) {
 bool NibblerSFML::_init() {
 	logInfo("loading SFML");
 
-	_win.create(sf::VideoMode(_gameInfo->realWidth, _gameInfo->realHeight), _gameInfo->title + " SFML");
+	// the font is loaded on a worker thread while the window is created (no GL call before the first draw)
+	std::future<bool> fontLoaded = std::async(std::launch::async, [this]() {
+		TRACE_SCOPE(_tracer, "load font");
+		return _font.loadFromFile(_gameInfo->font);
+	});
+	{
+		TRACE_SCOPE(_tracer, "create window");
+		_win.create(sf::VideoMode(_gameInfo->realWidth, _gameInfo->realHeight), _gameInfo->title + " SFML");
+	}
 
-	if (!_font.loadFromFile(_gameInfo->font)) {
+	if (!fontLoaded.get()) {
     	logErr("unable to load font " << _gameInfo->font);
 		return false;
 	}
@@ -43,6 +56,13 @@ bool NibblerSFML::_init() {
     return true;
 }
 
+void NibblerSFML::_setActive(bool active) {
+	_win.setVisible(active);
+	_win.setActive(active);  // GL context of the window
+	if (active)
+		_win.requestFocus();
+}
+
 void NibblerSFML::updateInput() {
 	while (_win.pollEvent(_event)) {
 		switch (_event.type) {
@@ -51,6 +71,12 @@ void NibblerSFML::updateInput() {
 				input.quit = true;
 				break;
 
+			// the window content must be drawn again (no timed wait in SFML: the default waitInput sleeps)
+			case sf::Event::Resized:
+			case sf::Event::GainedFocus:
+				_needRedraw = true;
+				break;
+
 			// key pressed
 			case sf::Event::KeyPressed:
 				if (_event.key.code == sf::Keyboard::Escape)
@@ -60,6 +86,8 @@ void NibblerSFML::updateInput() {
 					input.paused = !input.paused;
 				else if (_event.key.code == sf::Keyboard::R)
 					input.restart = true;
+				else if (_event.key.code == sf::Keyboard::F12)
+					input.saveTrace = true;
 
 				// move player 1
 				else if (_event.key.code == sf::Keyboard::Up)
@@ -110,6 +138,7 @@ void NibblerSFML::updateInput() {
 }
 
 bool NibblerSFML::draw() {
+	TRACE_SCOPE(_tracer, "NibblerSFML::draw");
 	// clear screen
 	_win.clear();
 
@@ -119,162 +148,162 @@ bool NibblerSFML::draw() {
 	float size = _gameInfo->height - (2 * BORDER_SIZE);
 	float step = size / _gameInfo->boardSize;
 
-	// border
-	sf::RectangleShape rect(sf::Vector2f(size + (2 * BORDER_SIZE), size + (2 * BORDER_SIZE)));
-	rect.setPosition(startX - BORDER_SIZE, startY - BORDER_SIZE);
-	rect.setFillColor(sf::Color(TO_SFML_COLOR(BORDER_COLOR)));
-	_win.draw(rect);
-
-
-	// draw board
-	for (int i = 0; i < _gameInfo->boardSize; i++) {
-		for (int j = 0; j < _gameInfo->boardSize; j++) {
-			sf::RectangleShape rect(sf::Vector2f(step, step));
-			rect.setPosition(startX + step * i, startY + step * j);
-			uint32_t color = ((i + j) & 1) ? SQUARE_COLOR_1 : SQUARE_COLOR_2;
-			rect.setFillColor(sf::Color(TO_SFML_COLOR(color)));
-			_win.draw(rect);
-		}
+	// border & board (cached)
+	if (_boardVerticesSize != _gameInfo->boardSize) {
+		_buildBoard(size, step);
 	}
+	_win.draw(_boardVertices);
+
+	// snakes, wall, food & bonus in one vertex array
+	_entitiesVertices.clear();
 	// draw snakes
 	for (int id = 0; id < _gameInfo->nbPlayers; id++) {
 		int		i = 0;
 		float	max = (_gameInfo->snakes[id].size() == 1) ? 1 : _gameInfo->snakes[id].size() - 1;
 		for (auto it = _gameInfo->snakes[id].begin(); it != _gameInfo->snakes[id].end(); it++) {
-			sf::RectangleShape rect(sf::Vector2f(step, step));
-			rect.setPosition(startX + step * it->x, startY + step * it->y);
 			uint32_t color = mixColor(getColor(id, 1), getColor(id, 2), i / max);
 			if (i >= 1 && max - i < _gameInfo->nbBonus[id])
 				color = BONUS_COLOR;
-			rect.setFillColor(sf::Color(TO_SFML_COLOR(color)));
-			_win.draw(rect);
+			_addQuad(_entitiesVertices, startX + step * it->x, startY + step * it->y, step, color);
 			i++;
 		}
 	}
 	// draw wall
 	for (auto it = _gameInfo->wall.begin(); it != _gameInfo->wall.end(); it++) {
-		sf::RectangleShape rect(sf::Vector2f(step, step));
-		rect.setPosition(startX + step * it->pos.x, startY + step * it->pos.y);
-		rect.setFillColor(sf::Color(TO_SFML_COLOR(WALL_COLOR)));
-		_win.draw(rect);
+		_addQuad(_entitiesVertices, startX + step * it->pos.x, startY + step * it->pos.y, step, WALL_COLOR);
 	}
 	// draw food
 	for (auto it = _gameInfo->food.begin(); it != _gameInfo->food.end(); it++) {
-		sf::RectangleShape rect(sf::Vector2f(step, step));
-		rect.setPosition(startX + step * it->x, startY + step * it->y);
-		rect.setFillColor(sf::Color(TO_SFML_COLOR(FOOD_COLOR)));
-		_win.draw(rect);
+		_addQuad(_entitiesVertices, startX + step * it->x, startY + step * it->y, step, FOOD_COLOR);
 	}
 	// draw bonus
 	for (auto it = _gameInfo->bonus.begin(); it != _gameInfo->bonus.end(); it++) {
-		sf::RectangleShape rect(sf::Vector2f(step, step));
-		rect.setPosition(startX + step * it->x, startY + step * it->y);
-		rect.setFillColor(sf::Color(TO_SFML_COLOR(BONUS_COLOR)));
-		_win.draw(rect);
+		_addQuad(_entitiesVertices, startX + step * it->x, startY + step * it->y, step, BONUS_COLOR);
 	}
+	_win.draw(_entitiesVertices);
 
-    {
-		// right band information
-		sf::Text text;
-		float textSize = _gameInfo->width / 35.0;
-		float textX = size + 2 * BORDER_SIZE + 10;
-		float textY = 5;
-		float textLnStep = textSize * 1.2;
-		text.setFont(_font);
-		text.setCharacterSize(textSize);
-		text.setFillColor(sf::Color(TO_SFML_COLOR(TEXT_COLOR)));
-
-		if (_gameInfo->nbPlayers == 1) {
-			text.setFillColor(sf::Color(TO_SFML_COLOR(getColor(0, 1))));
-			text.setString("Score : " + std::to_string(_gameInfo->scores[0]));
-			text.setPosition(textX, textY);
-			_win.draw(text);
-			textY += textLnStep;
-		}
-		else {
-			for (int id = 0; id < _gameInfo->nbPlayers; id++) {
-				uint32_t color = (_gameInfo->snakes[id].size() > 0) ? getColor(id, 1) : TEXT_COLOR;
-				text.setFillColor(sf::Color(TO_SFML_COLOR(color)));
-				std::string str = "Score ";
-				if (_gameInfo->isIA[id])
-					str += "[IA] ";
-				else if (id == 0)
-					str += "[arrow] ";
-				else
-					str += "[wasd] ";
-				str += std::to_string(id + 1) + " : " + std::to_string(_gameInfo->scores[id]);
-				text.setString(str);
-				text.setPosition(textX, textY);
-				_win.draw(text);
-				textY += textLnStep;
-			}
+	// HUD (re-layout only if the values changed)
+	if (_hudState.update(*_gameInfo)) {
+		_buildHud(size);
+	}
+	for (auto it = _hudTexts.begin(); it != _hudTexts.end(); it++) {
+		_win.draw(*it);
+	}
+
+	_win.display();
+	return true;
+}
+
+/*
+build the border and the board squares in _boardVertices
+this is called only when the boardSize change
+*/
+void NibblerSFML::_buildBoard(float size, float step) {
+	float startX = BORDER_SIZE;
+	float startY = BORDER_SIZE;
+
+	_boardVertices.clear();
+	// border
+	_addQuad(_boardVertices, startX - BORDER_SIZE, startY - BORDER_SIZE, size + (2 * BORDER_SIZE), BORDER_COLOR);
+	// board
+	for (int i = 0; i < _gameInfo->boardSize; i++) {
+		for (int j = 0; j < _gameInfo->boardSize; j++) {
+			uint32_t color = ((i + j) & 1) ? SQUARE_COLOR_1 : SQUARE_COLOR_2;
+			_addQuad(_boardVertices, startX + step * i, startY + step * j, step, color);
 		}
-		text.setFillColor(sf::Color(TO_SFML_COLOR(TEXT_COLOR)));
+	}
+	_boardVerticesSize = _gameInfo->boardSize;
+}
 
-		text.setString("Best: " + std::to_string(_gameInfo->bestScore));
-		text.setPosition(textX, textY);
-		_win.draw(text);
+/*
+build all texts of the HUD in _hudTexts
+this is called only when a value shown in the HUD change
+*/
+void NibblerSFML::_buildHud(float size) {
+	_hudTexts.clear();
 
+	// right band information
+	float textSize = _gameInfo->width / 35.0;
+	float textX = size + 2 * BORDER_SIZE + 10;
+	float textY = 5;
+	float textLnStep = textSize * 1.2;
+
+	if (_gameInfo->nbPlayers == 1) {
+		_addHudText("Score : " + std::to_string(_gameInfo->scores[0]), textX, textY, textSize, getColor(0, 1));
 		textY += textLnStep;
-		textY += textLnStep;
-		text.setString("arrow: move player 1");
-		text.setPosition(textX, textY);
-		_win.draw(text);
-		textY += textLnStep;
-		text.setString("Rshift: bonus player 1");
-		text.setPosition(textX, textY);
-		_win.draw(text);
-		textY += textLnStep;
-		if (_gameInfo->nbPlayers > 1 && _gameInfo->isIA[1] == false) {
-			text.setString("[wasd]: move player 2");
-			text.setPosition(textX, textY);
-			_win.draw(text);
-			textY += textLnStep;
-			text.setString("Lshift: bonus player 2");
-			text.setPosition(textX, textY);
-			_win.draw(text);
+	}
+	else {
+		for (int id = 0; id < _gameInfo->nbPlayers; id++) {
+			uint32_t color = (_gameInfo->snakes[id].size() > 0) ? getColor(id, 1) : TEXT_COLOR;
+			std::string str = "Score ";
+			if (_gameInfo->isIA[id])
+				str += "[IA] ";
+			else if (id == 0)
+				str += "[arrow] ";
+			else
+				str += "[wasd] ";
+			str += std::to_string(id + 1) + " : " + std::to_string(_gameInfo->scores[id]);
+			_addHudText(str, textX, textY, textSize, color);
 			textY += textLnStep;
 		}
-		text.setString("space: pause");
-		text.setPosition(textX, textY);
-		_win.draw(text);
+	}
+
+	_addHudText("Best: " + std::to_string(_gameInfo->bestScore), textX, textY, textSize, TEXT_COLOR);
+
+	textY += textLnStep;
+	textY += textLnStep;
+	_addHudText("arrow: move player 1", textX, textY, textSize, TEXT_COLOR);
+	textY += textLnStep;
+	_addHudText("Rshift: bonus player 1", textX, textY, textSize, TEXT_COLOR);
+	textY += textLnStep;
+	if (_gameInfo->nbPlayers > 1 && _gameInfo->isIA[1] == false) {
+		_addHudText("[wasd]: move player 2", textX, textY, textSize, TEXT_COLOR);
 		textY += textLnStep;
-		text.setString("r: restart");
-		text.setPosition(textX, textY);
-		_win.draw(text);
+		_addHudText("Lshift: bonus player 2", textX, textY, textSize, TEXT_COLOR);
 		textY += textLnStep;
 	}
+	_addHudText("space: pause", textX, textY, textSize, TEXT_COLOR);
+	textY += textLnStep;
+	_addHudText("r: restart", textX, textY, textSize, TEXT_COLOR);
+	textY += textLnStep;
 
 	if (_gameInfo->win || _gameInfo->gameOver || _gameInfo->paused) {
-		sf::Text text;
-		float textSize = _gameInfo->width / 10.0;
-		float textX = size / 3;
-		float textY = _gameInfo->height / 2 - textSize;
-		text.setFont(_font);
-		text.setCharacterSize(textSize);
-		text.setPosition(textX, textY);
+		float titleSize = _gameInfo->width / 10.0;
+		float titleX = size / 3;
+		float titleY = _gameInfo->height / 2 - titleSize;
 
 		if (_gameInfo->win) {
-			text.setFillColor(sf::Color(TO_SFML_COLOR(TEXT_WIN_COLOR)));
-			if (_gameInfo->nbPlayers == 1)
-				text.setString("You win !");
-			else
-				text.setString(((_gameInfo->isIA[_gameInfo->winnerID]) ? "IA " : "Player ")
-					+ std::to_string(_gameInfo->winnerID + 1) + " win !");
+			std::string str = "You win !";
+			if (_gameInfo->nbPlayers > 1)
+				str = ((_gameInfo->isIA[_gameInfo->winnerID]) ? "IA " : "Player ")
+					+ std::to_string(_gameInfo->winnerID + 1) + " win !";
+			_addHudText(str, titleX, titleY, titleSize, TEXT_WIN_COLOR);
 		}
 		else if (_gameInfo->gameOver) {
-			text.setFillColor(sf::Color(TO_SFML_COLOR(TEXT_GAMEOVER_COLOR)));
-			text.setString("Game over");
+			_addHudText("Game over", titleX, titleY, titleSize, TEXT_GAMEOVER_COLOR);
 		}
 		else if (_gameInfo->paused) {
-			text.setFillColor(sf::Color(TO_SFML_COLOR(TEXT_COLOR)));
-			text.setString("Pause");
+			_addHudText("Pause", titleX, titleY, titleSize, TEXT_COLOR);
 		}
-		_win.draw(text);
 	}
+}
 
-	_win.display();
-	return true;
+void NibblerSFML::_addHudText(std::string const & str, float x, float y, float textSize, uint32_t color) {
+	sf::Text text;
+	text.setFont(_font);
+	text.setCharacterSize(textSize);
+	text.setFillColor(sf::Color(TO_SFML_COLOR(color)));
+	text.setString(str);
+	text.setPosition(x, y);
+	_hudTexts.push_back(text);
+}
+
+void NibblerSFML::_addQuad(sf::VertexArray & vertices, float x, float y, float size, uint32_t color) {
+	sf::Color sfColor(TO_SFML_COLOR(color));
+	vertices.append(sf::Vertex(sf::Vector2f(x, y), sfColor));
+	vertices.append(sf::Vertex(sf::Vector2f(x + size, y), sfColor));
+	vertices.append(sf::Vertex(sf::Vector2f(x + size, y + size), sfColor));
+	vertices.append(sf::Vertex(sf::Vector2f(x, y + size), sfColor));
 }
 
 extern "C" {
@@ -1,7 +1,8 @@
 #include "ANibblerSound.hpp"
 #include "Logging.hpp"
 
-ANibblerSound::ANibblerSound() {}
+ANibblerSound::ANibblerSound()
+: _assetCache(nullptr) {}
 
 ANibblerSound::~ANibblerSound() {
 }
@@ -17,6 +18,10 @@ ANibblerSound &ANibblerSound::operator=(ANibblerSound const &rhs) {
 	return *this;
 }
 
-bool ANibblerSound::init(int nbSoundChannels) {
-	return _init(nbSoundChannels);
+bool ANibblerSound::init(int nbSoundChannels, int bufferSize) {
+	return _init(nbSoundChannels, bufferSize);
+}
+
+SoundStats ANibblerSound::getStats() const {
+	return SoundStats();
 }
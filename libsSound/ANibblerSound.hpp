@@ -1,12 +1,30 @@
 #pragma once
 
 #define NO_GUI_LOADED 255
+#define NO_SOUND_HANDLE -1
 
 #include <unistd.h>
+#include <stdint.h>
 #include <iostream>
 #include <deque>
 #include <vector>
 
+class SoundAssetCache;
+
+/* pre-resolved sound id (see getSoundHandle), avoid a name lookup for each played sound */
+typedef int32_t	SoundHandle;
+
+/* audio output counters, for monitoring */
+struct SoundStats {
+	uint64_t	nbCallbacks;  // audio buffers filled
+	uint64_t	nbUnderruns;  // audio callback called too late, the device was starved
+	uint64_t	nbMusicUnderruns;  // music not decoded in time, silence was played
+	uint64_t	nbDroppedCommands;  // play / stop commands lost because the queue was full
+	uint64_t	nbStolenVoices;  // sounds cut to play a new one
+
+	SoundStats() : nbCallbacks(0), nbUnderruns(0), nbMusicUnderruns(0), nbDroppedCommands(0), nbStolenVoices(0) {}
+};
+
 class ANibblerSound {
 	public:
 		ANibblerSound();
@@ -14,23 +32,35 @@ class ANibblerSound {
 		ANibblerSound(ANibblerSound const &src);
 		ANibblerSound &operator=(ANibblerSound const &rhs);
 
-		virtual	bool	init(int nbSoundChannels = 10);
+		/* bufferSize is the number of frames of the audio buffer (latency) */
+		virtual	bool	init(int nbSoundChannels = 10, int bufferSize = 1024);
+		/* the cache is owned by the game, it must be set before loading sounds */
+		void			setAssetCache(SoundAssetCache * assetCache) { _assetCache = assetCache; }
 
 		virtual bool	loadMusic(std::string const & name, std::string const & filename,
 			int soundLevel) = 0;
 		virtual void	update() = 0;
 		virtual bool	playMusic(std::string const & name, bool infinitePlay = true) = 0;
+		/* play the music after the current one (gapless) */
+		virtual bool	queueMusic(std::string const & name, bool infinitePlay = true) = 0;
 		virtual bool	pause(bool paused) = 0;
 		virtual bool	restart() = 0;
 
 		virtual bool	loadSound(std::string const & name, std::string const & filename,
 			int soundLevel) = 0;
 		virtual bool	playSound(std::string const & name, int channel = 0) = 0;
+		/* return NO_SOUND_HANDLE if the sound is not loaded */
+		virtual SoundHandle	getSoundHandle(std::string const & name) = 0;
+		/* channel -1 to play on any free channel */
+		virtual bool	playSound(SoundHandle handle, int channel = 0) = 0;
 		virtual bool	stopAllSounds() = 0;
 		virtual bool	stopSound(int channel) = 0;
+		virtual SoundStats	getStats() const;
 
 	protected:
-		virtual	bool	_init(int nbSoundChannels) = 0;
+		SoundAssetCache *	_assetCache;
+
+		virtual	bool	_init(int nbSoundChannels, int bufferSize) = 0;
 };
 
 typedef ANibblerSound *(*nibblerSoundCreator)();
@@ -0,0 +1,55 @@
+#include <sys/stat.h>
+#include <utility>
+#include "SoundAssetCache.hpp"
+
+SoundAssetCache::SoundAssetCache()
+: _mutex(),
+  _assets() {}
+
+SoundAssetCache::~SoundAssetCache() {
+}
+
+SoundAssetCache::SoundAssetCache(SoundAssetCache const &src) {
+	*this = src;
+}
+
+SoundAssetCache &SoundAssetCache::operator=(SoundAssetCache const &rhs) {
+	(void)rhs;
+	// the cache is shared by pointer, it is never copied
+	return *this;
+}
+
+/*
+	return the key of a file for a given variant (decoded format, raw file, ...)
+	the modification time is part of the key so an edited file is decoded again
+	return an empty string if the file doesn't exist
+*/
+std::string SoundAssetCache::makeKey(std::string const & filename, std::string const & variant) {
+	struct stat	st;
+
+	if (stat(filename.c_str(), &st) != 0)
+		return "";
+	return filename + "|" + variant + "|" + std::to_string(st.st_mtime);
+}
+
+/*
+	return the asset or nullptr if it is not in the cache
+*/
+std::vector<uint8_t> const * SoundAssetCache::find(std::string const & key) {
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	auto it = _assets.find(key);
+	if (it == _assets.end())
+		return nullptr;
+	return &it->second;
+}
+
+/*
+	add an asset to the cache
+	if another thread already added the same key, the existing asset is kept and returned
+*/
+std::vector<uint8_t> const * SoundAssetCache::insert(std::string const & key, std::vector<uint8_t> && data) {
+	std::lock_guard<std::mutex>	lock(_mutex);
+
+	return &_assets.insert(std::make_pair(key, std::move(data))).first->second;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	decoded sound assets shared by every sound backend
+
+	the cache is owned by the game and only holds plain data (no vtable, no callback)
+	so it stays valid when a sound backend is unloaded.
+	an entry is never erased: pointers returned by find / insert stay valid as long as the cache lives
+*/
+class SoundAssetCache {
+	public:
+		SoundAssetCache();
+		virtual ~SoundAssetCache();
+		SoundAssetCache(SoundAssetCache const &src);
+		SoundAssetCache &operator=(SoundAssetCache const &rhs);
+
+		static std::string				makeKey(std::string const & filename, std::string const & variant);
+		std::vector<uint8_t> const *	find(std::string const & key);
+		std::vector<uint8_t> const *	insert(std::string const & key, std::vector<uint8_t> && data);
+
+	private:
+		std::mutex										_mutex;
+		std::map<std::string, std::vector<uint8_t>>	_assets;
+};
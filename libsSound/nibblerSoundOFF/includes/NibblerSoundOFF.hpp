@@ -13,14 +13,17 @@ class NibblerSoundOFF : public ANibblerSound {
 		virtual bool	loadMusic(std::string const & name, std::string const & filename, int soundLevel);
 		virtual void	update();
 		virtual bool	playMusic(std::string const & name, bool infinitePlay = true);
+		virtual bool	queueMusic(std::string const & name, bool infinitePlay = true);
 		virtual bool	pause(bool paused);
 		virtual bool	restart();
 
 		virtual bool	loadSound(std::string const & name, std::string const & filename, int soundLevel);
 		virtual bool	playSound(std::string const & name, int channel = 0);
+		virtual SoundHandle	getSoundHandle(std::string const & name);
+		virtual bool	playSound(SoundHandle handle, int channel = 0);
 		virtual bool	stopAllSounds();
 		virtual bool	stopSound(int channel);
 
 	private:
-		virtual bool	_init(int nbSoundChannels);
+		virtual bool	_init(int nbSoundChannels, int bufferSize);
 };
@@ -27,8 +27,9 @@ NibblerSoundOFF &NibblerSoundOFF::operator=(NibblerSoundOFF const &rhs) {
 	return *this;
 }
 
-bool NibblerSoundOFF::_init(int nbSoundChannels) {
+bool NibblerSoundOFF::_init(int nbSoundChannels, int bufferSize) {
 	(void)nbSoundChannels;
+	(void)bufferSize;
     return true;
 }
 
@@ -48,6 +49,12 @@ bool	NibblerSoundOFF::playMusic(std::string const & name, bool infinitePlay) {
 	return true;
 }
 
+bool	NibblerSoundOFF::queueMusic(std::string const & name, bool infinitePlay) {
+	(void)name;
+	(void)infinitePlay;
+	return true;
+}
+
 bool	NibblerSoundOFF::pause(bool infinitePlay) {
 	(void)infinitePlay;
 	return true;
@@ -70,6 +77,17 @@ bool	NibblerSoundOFF::playSound(std::string const & name, int channel) {
 	return true;
 }
 
+SoundHandle	NibblerSoundOFF::getSoundHandle(std::string const & name) {
+	(void)name;
+	return NO_SOUND_HANDLE;
+}
+
+bool	NibblerSoundOFF::playSound(SoundHandle handle, int channel) {
+	(void)handle;
+	(void)channel;
+	return true;
+}
+
 bool	NibblerSoundOFF::stopAllSounds() {
 	return true;
 }
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MUSIC_RING_SIZE (1 << 16)  // samples in the ring buffer (~0.7s at 44100Hz stereo)
+#define MUSIC_CHUNK_SIZE 4096  // bytes read from the file at once
+#define MUSIC_IO_SLEEP_MS 20  // I/O thread wait when the ring buffer is full
+
+/*
+	stream a wav music from the disk with a constant memory usage
+	an I/O thread reads & converts the file in chunks into a ring buffer, the audio callback reads the ring buffer
+	the next track is decoded right after the current one so the switch has no gap
+*/
+class MusicStream {
+	public:
+		MusicStream();
+		virtual ~MusicStream();
+		MusicStream(MusicStream const &src);
+		MusicStream &operator=(MusicStream const &rhs);
+
+		bool		start(int freq, Uint16 format, int channels);
+		void		stop();
+
+		/* now: cut the current track, else the track is played after the current one (gapless) */
+		void		play(std::string const & filename, int vol, bool loop, bool now);
+		void		halt();
+		void		setPaused(bool paused);
+		bool		isPlaying() const;
+		uint64_t	getUnderruns() const;
+
+		static bool	isValid(std::string const & filename);
+		/* audio thread (Mix_HookMusic callback) */
+		static void	hook(void * udata, Uint8 * stream, int len);
+
+	private:
+		struct Track {
+			std::string	filename;
+			int			vol;
+			bool		loop;
+		};
+		struct WavInfo {
+			Uint16		format;
+			int			channels;
+			int			freq;
+			uint32_t	dataStart;
+			uint32_t	dataSize;
+		};
+
+		// device format
+		int							_freq;
+		Uint16						_format;
+		int							_channels;
+
+		// shared with the audio callback (lock-free)
+		std::vector<int16_t>		_ring;
+		std::atomic<uint64_t>		_readPos;  // written by the audio callback only
+		std::atomic<uint64_t>		_writePos;  // written by the I/O thread only
+		std::atomic<uint64_t>		_skipUntil;  // the callback drop everything before this position
+		std::atomic<bool>			_paused;
+		std::atomic<bool>			_playing;
+		std::atomic<uint64_t>		_nbUnderruns;
+
+		// commands for the I/O thread
+		std::thread					_thread;
+		std::mutex					_mutex;
+		std::condition_variable		_cond;
+		bool						_quit;
+		bool						_switchNow;
+		std::deque<Track>			_queue;
+
+		// current track, used by the I/O thread only
+		Track						_track;
+		WavInfo						_wav;
+		std::ifstream				_file;
+		uint32_t					_dataRead;
+		bool						_passRead;  // data was read since the start of the track (or of the loop)
+		bool						_flushed;  // the end of the track was sent to the converter
+		SDL_AudioStream *			_stream;
+		std::vector<uint8_t>		_chunk;
+		std::vector<int16_t>		_converted;
+
+		void		_ioLoop();
+		bool		_openTrack(Track const & track);
+		void		_closeTrack();
+		bool		_decodeChunk();
+		uint32_t	_ringFree() const;
+		void		_write(int16_t const * samples, uint32_t nbSamples);
+		void		_read(int16_t * stream, uint32_t nbSamples);
+		static bool	_readWavInfo(std::ifstream & file, WavInfo & info);
+};
@@ -5,7 +5,17 @@
 #include <SDL2/SDL_mixer.h>
 #include <map>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <vector>
 #include "ANibblerSound.hpp"
+#include "SoundAssetCache.hpp"
+#include "SpscQueue.hpp"
+#include "MusicStream.hpp"
+
+#define SOUND_QUEUE_SIZE 256  // max commands sent to the audio callback between two audio buffers
+#define SOUND_UNDERRUN_RATIO 2  // the callback is late if called after SOUND_UNDERRUN_RATIO buffers duration
 
 class NibblerSoundSDL : public ANibblerSound {
 	public:
@@ -17,34 +27,96 @@ class NibblerSoundSDL : public ANibblerSound {
 		virtual bool	loadMusic(std::string const & name, std::string const & filename, int soundLevel);
 		virtual void	update();
 		virtual bool	playMusic(std::string const & name, bool infinitePlay = true);
+		virtual bool	queueMusic(std::string const & name, bool infinitePlay = true);
 		virtual bool	pause(bool paused);
 		virtual bool	restart();
 
 		virtual bool	loadSound(std::string const & name, std::string const & filename, int soundLevel);
 		virtual bool	playSound(std::string const & name, int channel = 0);
+		virtual SoundHandle	getSoundHandle(std::string const & name);
+		virtual bool	playSound(SoundHandle handle, int channel = 0);
 		virtual bool	stopAllSounds();
 		virtual bool	stopSound(int channel);
+		virtual SoundStats	getStats() const;
 
 	private:
-		virtual bool	_init(int nbSoundChannels);
+		virtual bool	_init(int nbSoundChannels, int bufferSize);
+
+		/* decoded asset, nullptr if the decoding failed */
+		typedef std::future<std::vector<uint8_t> const *>	AssetFuture;
 
 		struct Music {
 			std::string	filename;
-			Mix_Music *	music;
 			int			vol;
-
-			Music() : music(nullptr) {}
+			bool		streamed;  // false: played by SDL_mixer (format not supported by MusicStream)
 		};
 
 		std::map<std::string, Music>	_music;
 		std::string						_actMusic;
+		MusicStream						_musicStream;  // played with Mix_HookMusic
+		bool							_streaming;  // false: the music is played by SDL_mixer (device not in S16)
+		Mix_Music *						_mixMusic;  // the current music is played by SDL_mixer if not nullptr
 
 		struct Sound {
-			std::string	filename;
-			Mix_Chunk *	sound;
+			std::string						filename;
+			std::vector<uint8_t> const *	data;  // samples in the mixer format, owned by the cache
+			int								vol;
+			AssetFuture						pending;  // valid while the file is decoded in background
+			Mix_Chunk *						chunk;  // only if the sounds are played by SDL_mixer (not mixed)
 
-			Sound() : sound(nullptr) {}
+			Sound() : data(nullptr), vol(0), pending(), chunk(nullptr) {}
 		};
 
-		std::map<std::string, Sound>	_sound;
+		std::vector<Sound>					_sound;  // index is the SoundHandle
+		std::map<std::string, SoundHandle>	_soundHandles;
+
+		/*
+			the sounds are mixed over SDL_mixer output in the audio callback (Mix_SetPostMix)
+			the game thread only sends commands, the voices are owned by the audio callback
+		*/
+		struct Command {
+			enum Type { PLAY, STOP };
+
+			Type			type;
+			int				channel;  // -1: any free voice for PLAY, all voices for STOP
+			int				vol;
+			int16_t const *	samples;
+			uint32_t		nbSamples;
+		};
+		struct Voice {
+			int16_t const *	samples;  // nullptr if the voice is free
+			uint32_t		nbSamples;
+			uint32_t		pos;
+			int				vol;
+		};
+
+		bool								_mixing;  // post mix callback running, else the sounds use SDL_mixer
+		int									_nbChannels;
+		SpscQueue<Command, SOUND_QUEUE_SIZE>	_commands;
+		std::vector<Voice>					_voices;
+		Uint64								_lastCallback;
+		Uint64								_perfFreq;
+		std::atomic<uint64_t>				_nbCallbacks;
+		std::atomic<uint64_t>				_nbUnderruns;
+		std::atomic<uint64_t>				_nbStolenVoices;
+		uint64_t							_nbDroppedCommands;
+
+		// output format of the mixer, the sounds are decoded in this format
+		int								_freq;
+		Uint16							_format;
+		int								_channels;
+		SoundAssetCache					_localCache;  // used if the game doesn't share a cache
+
+		SoundAssetCache *	_cache();
+		bool				_loadSound(Sound & sound);
+		bool				_playMixMusic(Music const & music, bool infinitePlay);
+		void				_stopMixMusic();
+		bool				_playMixSound(Sound & sound, int channel);
+		bool				_pushCommand(Command const & command);
+		void				_mix(int16_t * stream, uint32_t nbSamples);
+		void				_startVoice(Command const & command);
+		static void			_postMix(void * udata, Uint8 * stream, int len);
+		static bool			_isReady(AssetFuture & future);
+		static std::vector<uint8_t> const *	_decodeSound(SoundAssetCache * cache, std::string key,
+			std::string filename, int freq, Uint16 format, int channels);
 };
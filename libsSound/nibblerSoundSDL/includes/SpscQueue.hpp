@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+/*
+	lock-free single producer / single consumer queue
+	the producer is the game thread, the consumer is the audio callback: no lock & no allocation
+	SIZE must be a power of 2 (one slot is kept empty to distinguish full & empty)
+*/
+template<class T, uint32_t SIZE>
+class SpscQueue {
+	static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "SpscQueue SIZE must be a power of 2");
+
+	public:
+		SpscQueue() : _head(0), _tail(0) {}
+		virtual ~SpscQueue() {}
+		SpscQueue(SpscQueue const &src) : _head(0), _tail(0) { *this = src; }
+		SpscQueue &operator=(SpscQueue const &rhs) {
+			(void)rhs;
+			// a queue is shared between two threads, it is never copied
+			return *this;
+		}
+
+		/* producer side, return false if the queue is full */
+		bool	push(T const & value) {
+			uint32_t tail = _tail.load(std::memory_order_relaxed);
+			uint32_t next = (tail + 1) & (SIZE - 1);
+			if (next == _head.load(std::memory_order_acquire))
+				return false;
+			_buffer[tail] = value;
+			_tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/* consumer side, return false if the queue is empty */
+		bool	pop(T & value) {
+			uint32_t head = _head.load(std::memory_order_relaxed);
+			if (head == _tail.load(std::memory_order_acquire))
+				return false;
+			value = _buffer[head];
+			_head.store((head + 1) & (SIZE - 1), std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T						_buffer[SIZE];
+		std::atomic<uint32_t>	_head;  // written by the consumer only
+		std::atomic<uint32_t>	_tail;  // written by the producer only
+};
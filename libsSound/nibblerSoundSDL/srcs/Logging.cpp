@@ -1,9 +1,22 @@
+#include <chrono>
+#include <cstring>
 #include "Logging.hpp"
 
 Logging		logging;
 
 Logging::Logging()
-: _loglevel(LOGDEBUG) {
+: _loglevel(LOGDEBUG),
+  _writePos(0),
+  _readPos(0),
+  _nbDropped(0),
+  _quit(false),
+  _sleeping(false),
+  _mutex(),
+  _cond(),
+  _thread() {
+	for (uint64_t i = 0; i < LOG_QUEUE_SIZE; i++)
+		_slots[i].seq.store(i, std::memory_order_relaxed);
+
 	setLogColor(LOGDEBUG, COLOR_WHITE);
 	setLogColor(LOGINFO, COLOR_WHITE);
 	setLogColor(LOGSUCCESS, std::string(COLOR_GREEN) + COLOR_BOLD);
@@ -12,13 +25,23 @@ Logging::Logging()
 	setLogColor(LOGFATAL, std::string(COLOR_RED) + COLOR_BOLD);
 
 	setPrintFileLine(false);
+
+	_thread = std::thread(&Logging::_writeLoop, this);
 }
 
-Logging::Logging(Logging const &src) {
+Logging::Logging(Logging const &src)
+: Logging() {
 	*this = src;
 }
 
 Logging::~Logging() {
+	_quit.store(true);
+	_wake();
+	if (_thread.joinable())
+		_thread.join();
+	// logs pushed while the thread was stopping
+	while (_writeNext()) {}
+	std::cout.flush();
 }
 
 Logging & Logging::operator=(Logging const &rhs) {
@@ -44,9 +67,136 @@ void Logging::setPrintFileLine(bool printFileLine) {
 	}
 }
 
-void	Logging::log(eLoglevel level, std::string message, std::string file, int line) {
+/*
+	push the log in the queue (lock-free), the logging thread write it
+*/
+void	Logging::log(eLoglevel level, std::string const & message, char const * file, int line) {
 	if (level < _loglevel)
 		return;
+	if (_quit.load(std::memory_order_relaxed)) {
+		// the logging thread is stopped (end of the program)
+		_write(std::cout, level, _printFileLine[level], file, line, message.c_str(), message.size());
+		std::cout.flush();
+		return;
+	}
+
+	// reserve a slot
+	uint64_t	pos = _writePos.load(std::memory_order_relaxed);
+	Slot *		slot;
+	while (true) {
+		slot = &_slots[pos & (LOG_QUEUE_SIZE - 1)];
+		int64_t diff = static_cast<int64_t>(slot->seq.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (_writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) {  // queue is full
+			_nbDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else {
+			pos = _writePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	Record & record = slot->record;
+	record.level = level;
+	record.file = file;
+	record.line = line;
+	record.printFileLine = _printFileLine[level];
+	record.size = message.size();
+	if (message.size() < LOG_MSG_SIZE) {
+		record.longMessage = nullptr;
+		std::memcpy(record.message, message.c_str(), message.size());
+	}
+	else {
+		record.longMessage = new std::string(message);
+	}
+	slot->seq.store(pos + 1, std::memory_order_release);
+	// the mutex is only taken if the logging thread is sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (_sleeping.load(std::memory_order_relaxed))
+		_wake();
+}
+
+void	Logging::flush() {
+	uint64_t pos = _writePos.load();
+	_wake();
+	while (_readPos.load() < pos && _thread.joinable() && _quit.load() == false) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+std::string const &	Logging::getColor(eLoglevel loglevel) const { return _colors[loglevel]; }
+eLoglevel			Logging::getLoglevel() const { return _loglevel; }
+uint64_t			Logging::getNbDropped() const { return _nbDropped.load(std::memory_order_relaxed); }
+
+// -- private -----------------------------------------------------------------
+
+void	Logging::_writeLoop() {
+	uint64_t	nbDropped = 0;
+	while (true) {
+		bool quit = _quit.load();
+		bool written = false;
+		while (_writeNext())
+			written = true;
+		if (_nbDropped.load(std::memory_order_relaxed) != nbDropped) {
+			nbDropped = _nbDropped.load(std::memory_order_relaxed);
+			std::string msg = "log queue full, " + std::to_string(nbDropped) + " logs dropped";
+			_write(std::cout, LOGWARN, false, "", -1, msg.c_str(), msg.size());
+			written = true;
+		}
+		if (written)
+			std::cout.flush();
+		if (quit)
+			return;
+		// sleep until a log is pushed (no timeout, the producers wake the thread)
+		std::unique_lock<std::mutex>	lock(_mutex);
+		_sleeping.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		_cond.wait(lock, [this, nbDropped]() {
+			uint64_t pos = _readPos.load(std::memory_order_relaxed);
+			return _quit.load()
+				|| _slots[pos & (LOG_QUEUE_SIZE - 1)].seq.load(std::memory_order_acquire) == pos + 1
+				|| _nbDropped.load(std::memory_order_relaxed) != nbDropped;
+		});
+		_sleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+/*
+	wake the logging thread, the mutex is locked so the notify can't be lost between the check & the wait
+*/
+void	Logging::_wake() {
+	std::lock_guard<std::mutex>	lock(_mutex);
+	_cond.notify_one();
+}
+
+/*
+	logging thread: write the next log, return false if the queue is empty
+*/
+bool	Logging::_writeNext() {
+	uint64_t	pos = _readPos.load(std::memory_order_relaxed);
+	Slot &		slot = _slots[pos & (LOG_QUEUE_SIZE - 1)];
+	if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+		return false;
+
+	Record & record = slot.record;
+	if (record.longMessage != nullptr) {
+		_write(std::cout, record.level, record.printFileLine, record.file, record.line,
+			record.longMessage->c_str(), record.size);
+		delete record.longMessage;
+	}
+	else {
+		_write(std::cout, record.level, record.printFileLine, record.file, record.line, record.message, record.size);
+	}
+	slot.seq.store(pos + LOG_QUEUE_SIZE, std::memory_order_release);
+	_readPos.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+void	Logging::_write(std::ostream & out, eLoglevel level, bool printFileLine, char const * file, int line,
+char const * message, uint32_t size) const {
 	std::stringstream ss;
 	// start logging
 	ss << _colors[level];
@@ -56,14 +206,11 @@ void	Logging::log(eLoglevel level, std::string message, std::string file, int li
 	else if (level == LOGWARN) ss << "[WARN]";
 	else if (level == LOGERROR) ss << "[ERROR]";
 	else if (level == LOGFATAL) ss << "[FATAL]";
-	if (_printFileLine[level])
+	if (printFileLine)
 		ss << "[" << file << " " << line << "]";
 	ss << ": ";
-	ss << message;
-	ss << COLOR_EOC << std::endl;
+	ss.write(message, size);
+	ss << COLOR_EOC << "\n";
 
-	std::cout << ss.str();
+	out << ss.str();
 }
-
-std::string const &	Logging::getColor(eLoglevel loglevel) const { return _colors[loglevel]; }
-eLoglevel			Logging::getLoglevel() const { return _loglevel; }
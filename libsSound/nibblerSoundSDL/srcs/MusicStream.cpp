@@ -0,0 +1,343 @@
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "MusicStream.hpp"
+#include "Logging.hpp"
+
+MusicStream::MusicStream()
+: _freq(44100),
+  _format(AUDIO_S16SYS),
+  _channels(2),
+  _ring(MUSIC_RING_SIZE, 0),
+  _readPos(0),
+  _writePos(0),
+  _skipUntil(0),
+  _paused(false),
+  _playing(false),
+  _nbUnderruns(0),
+  _thread(),
+  _mutex(),
+  _cond(),
+  _quit(false),
+  _switchNow(false),
+  _queue(),
+  _track(),
+  _wav(),
+  _file(),
+  _dataRead(0),
+  _passRead(false),
+  _flushed(false),
+  _stream(nullptr),
+  _chunk(MUSIC_CHUNK_SIZE),
+  _converted(MUSIC_CHUNK_SIZE) {}
+
+MusicStream::~MusicStream() {
+	stop();
+}
+
+MusicStream::MusicStream(MusicStream const &src)
+: MusicStream() {
+	*this = src;
+}
+
+MusicStream &MusicStream::operator=(MusicStream const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use MusicStream copy operator");
+	}
+	return *this;
+}
+
+/*
+	start the I/O thread, the music is converted to the given device format
+*/
+bool	MusicStream::start(int freq, Uint16 format, int channels) {
+	if (_thread.joinable())
+		return true;
+	if (format != AUDIO_S16SYS) {
+		logErr("music stream: unsupported device format " << format);
+		return false;
+	}
+	_freq = freq;
+	_format = format;
+	_channels = channels;
+	_quit = false;
+	_thread = std::thread(&MusicStream::_ioLoop, this);
+	return true;
+}
+
+void	MusicStream::stop() {
+	if (_thread.joinable() == false)
+		return;
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_quit = true;
+	}
+	_cond.notify_one();
+	_thread.join();
+}
+
+void	MusicStream::play(std::string const & filename, int vol, bool loop, bool now) {
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		if (now) {
+			_queue.clear();
+			_switchNow = true;
+		}
+		_queue.push_back({filename, vol, loop});
+	}
+	_cond.notify_one();
+}
+
+void	MusicStream::halt() {
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+		_queue.clear();
+		_switchNow = true;
+	}
+	_cond.notify_one();
+}
+
+void	MusicStream::setPaused(bool paused) {
+	_paused.store(paused, std::memory_order_relaxed);
+}
+
+bool	MusicStream::isPlaying() const {
+	return _playing.load(std::memory_order_relaxed);
+}
+
+uint64_t	MusicStream::getUnderruns() const {
+	return _nbUnderruns.load(std::memory_order_relaxed);
+}
+
+/*
+	check that the file is a wav that can be streamed (only the header is read)
+*/
+bool	MusicStream::isValid(std::string const & filename) {
+	std::ifstream	file(filename, std::ios::binary);
+	WavInfo			info;
+
+	return file && _readWavInfo(file, info);
+}
+
+void	MusicStream::hook(void * udata, Uint8 * stream, int len) {
+	reinterpret_cast<MusicStream *>(udata)->_read(reinterpret_cast<int16_t *>(stream), len / sizeof(int16_t));
+}
+
+// -- private -----------------------------------------------------------------
+
+void	MusicStream::_ioLoop() {
+	std::unique_lock<std::mutex>	lock(_mutex);
+
+	while (_quit == false) {
+		// open the next track: now if asked, else at the end of the current one (gapless)
+		if (_switchNow || (_file.is_open() == false && _queue.empty() == false)) {
+			if (_switchNow) {
+				// drop what is still in the ring buffer
+				_playing.store(false, std::memory_order_relaxed);
+				_skipUntil.store(_writePos.load(std::memory_order_relaxed), std::memory_order_release);
+				_switchNow = false;
+			}
+			_closeTrack();
+			while (_queue.empty() == false) {
+				Track track = _queue.front();
+				_queue.pop_front();
+				if (_openTrack(track))
+					break;
+			}
+		}
+
+		if (_file.is_open() == false) {
+			// the last samples are written, an empty ring buffer is not an underrun anymore
+			_playing.store(false, std::memory_order_relaxed);
+			_cond.wait(lock);
+			continue;
+		}
+		if (_ringFree() < MUSIC_RING_SIZE / 4) {
+			_cond.wait_for(lock, std::chrono::milliseconds(MUSIC_IO_SLEEP_MS));
+			continue;
+		}
+
+		lock.unlock();
+		bool notEnded = _decodeChunk();
+		lock.lock();
+		if (notEnded == false)
+			_closeTrack();
+	}
+	_closeTrack();
+}
+
+bool	MusicStream::_openTrack(Track const & track) {
+	_file.open(track.filename, std::ios::binary);
+	if (!_file || _readWavInfo(_file, _wav) == false) {
+		logErr("while loading music " << track.filename << ": invalid wav file");
+		_file.close();
+		return false;
+	}
+	_stream = SDL_NewAudioStream(_wav.format, _wav.channels, _wav.freq, _format, _channels, _freq);
+	if (_stream == nullptr) {
+		logErr("while loading music " << track.filename << ": " << SDL_GetError());
+		_file.close();
+		return false;
+	}
+	_file.seekg(_wav.dataStart);
+	_track = track;
+	_dataRead = 0;
+	_passRead = false;
+	_flushed = false;
+	return true;
+}
+
+void	MusicStream::_closeTrack() {
+	if (_file.is_open())
+		_file.close();
+	_file.clear();
+	if (_stream != nullptr) {
+		SDL_FreeAudioStream(_stream);
+		_stream = nullptr;
+	}
+}
+
+/*
+	push the converted samples to the ring buffer, or read a new chunk of the file if there are none
+	return false at the end of the track
+*/
+bool	MusicStream::_decodeChunk() {
+	int available = SDL_AudioStreamAvailable(_stream);
+	if (available > 0) {
+		uint32_t nbSamples = std::min(static_cast<uint32_t>(available / sizeof(int16_t)),
+			std::min(_ringFree(), static_cast<uint32_t>(_converted.size())));
+		int size = SDL_AudioStreamGet(_stream, _converted.data(), nbSamples * sizeof(int16_t));
+		if (size < 0) {
+			logErr("while streaming music " << _track.filename << ": " << SDL_GetError());
+			return false;
+		}
+		_write(_converted.data(), size / sizeof(int16_t));
+		return true;
+	}
+
+	if (_dataRead >= _wav.dataSize) {
+		// a pass without any data (truncated file) would loop forever without filling the ring buffer
+		if (_track.loop && _passRead) {
+			// restart the track without flushing the converter: no gap between the loops
+			_file.clear();
+			_file.seekg(_wav.dataStart);
+			_dataRead = 0;
+			_passRead = false;
+			return true;
+		}
+		if (_flushed == false) {
+			SDL_AudioStreamFlush(_stream);
+			_flushed = true;
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t size = std::min(static_cast<uint32_t>(_chunk.size()), _wav.dataSize - _dataRead);
+	_file.read(reinterpret_cast<char *>(_chunk.data()), size);
+	size = _file.gcount();
+	if (size == 0) {  // truncated file
+		_dataRead = _wav.dataSize;
+		return true;
+	}
+	_dataRead += size;
+	_passRead = true;
+	if (SDL_AudioStreamPut(_stream, _chunk.data(), size) < 0) {
+		logErr("while streaming music " << _track.filename << ": " << SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+uint32_t	MusicStream::_ringFree() const {
+	uint64_t used = _writePos.load(std::memory_order_relaxed) - _readPos.load(std::memory_order_acquire);
+	return MUSIC_RING_SIZE - used;
+}
+
+/*
+	I/O thread: the volume is applied here so a new track keeps its own volume
+*/
+void	MusicStream::_write(int16_t const * samples, uint32_t nbSamples) {
+	uint64_t writePos = _writePos.load(std::memory_order_relaxed);
+	for (uint32_t i = 0; i < nbSamples; i++) {
+		_ring[(writePos + i) & (MUSIC_RING_SIZE - 1)] = samples[i] * _track.vol / MIX_MAX_VOLUME;
+	}
+	_writePos.store(writePos + nbSamples, std::memory_order_release);
+	_playing.store(true, std::memory_order_relaxed);
+}
+
+/*
+	audio thread: no lock, no allocation. output silence if the ring buffer is empty
+*/
+void	MusicStream::_read(int16_t * stream, uint32_t nbSamples) {
+	if (_paused.load(std::memory_order_relaxed)) {
+		std::memset(stream, 0, nbSamples * sizeof(int16_t));
+		return;
+	}
+
+	uint64_t readPos = _readPos.load(std::memory_order_relaxed);
+	uint64_t skipUntil = _skipUntil.load(std::memory_order_acquire);
+	if (readPos < skipUntil)
+		readPos = skipUntil;
+	uint64_t writePos = _writePos.load(std::memory_order_acquire);
+
+	uint32_t nb = std::min(static_cast<uint64_t>(nbSamples), writePos - readPos);
+	for (uint32_t i = 0; i < nb; i++) {
+		stream[i] = _ring[(readPos + i) & (MUSIC_RING_SIZE - 1)];
+	}
+	std::memset(stream + nb, 0, (nbSamples - nb) * sizeof(int16_t));
+	_readPos.store(readPos + nb, std::memory_order_release);
+
+	if (nb < nbSamples && _playing.load(std::memory_order_relaxed))
+		_nbUnderruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+	read the RIFF header, stop at the beginning of the data chunk
+*/
+bool	MusicStream::_readWavInfo(std::ifstream & file, WavInfo & info) {
+	uint8_t		buf[16];
+	auto		read16 = [&buf](int i) { return static_cast<uint32_t>(buf[i] | (buf[i + 1] << 8)); };
+	auto		read32 = [&buf](int i) {
+		return static_cast<uint32_t>(buf[i] | (buf[i + 1] << 8) | (buf[i + 2] << 16) | (buf[i + 3] << 24));
+	};
+
+	if (!file.read(reinterpret_cast<char *>(buf), 12)
+	|| std::memcmp(buf, "RIFF", 4) != 0 || std::memcmp(buf + 8, "WAVE", 4) != 0)
+		return false;
+
+	bool fmtFound = false;
+	while (file.read(reinterpret_cast<char *>(buf), 8)) {
+		uint32_t chunkSize = read32(4);
+		if (std::memcmp(buf, "fmt ", 4) == 0) {
+			if (chunkSize < 16 || !file.read(reinterpret_cast<char *>(buf), 16))
+				return false;
+			uint32_t audioFormat = read16(0);
+			uint32_t bits = read16(14);
+			info.channels = read16(2);
+			info.freq = read32(4);
+			if (audioFormat == 1 && bits == 8)
+				info.format = AUDIO_U8;
+			else if (audioFormat == 1 && bits == 16)
+				info.format = AUDIO_S16LSB;
+			else if (audioFormat == 1 && bits == 32)
+				info.format = AUDIO_S32LSB;
+			else if (audioFormat == 3 && bits == 32)
+				info.format = AUDIO_F32LSB;
+			else
+				return false;
+			file.seekg((chunkSize - 16) + (chunkSize & 1), std::ios::cur);
+			fmtFound = true;
+		}
+		else if (std::memcmp(buf, "data", 4) == 0) {
+			info.dataStart = file.tellg();
+			info.dataSize = chunkSize;
+			return fmtFound && chunkSize > 0;
+		}
+		else {
+			file.seekg(chunkSize + (chunkSize & 1), std::ios::cur);
+		}
+	}
+	return false;
+}
@@ -1,7 +1,31 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include "NibblerSoundSDL.hpp"
 #include "Logging.hpp"
 
-NibblerSoundSDL::NibblerSoundSDL() {
+NibblerSoundSDL::NibblerSoundSDL()
+: _music(),
+  _actMusic(),
+  _musicStream(),
+  _streaming(false),
+  _mixMusic(nullptr),
+  _sound(),
+  _soundHandles(),
+  _mixing(false),
+  _nbChannels(0),
+  _commands(),
+  _voices(),
+  _lastCallback(0),
+  _perfFreq(SDL_GetPerformanceFrequency()),
+  _nbCallbacks(0),
+  _nbUnderruns(0),
+  _nbStolenVoices(0),
+  _nbDroppedCommands(0),
+  _freq(44100),
+  _format(MIX_DEFAULT_FORMAT),
+  _channels(MIX_DEFAULT_CHANNELS),
+  _localCache() {
 	// init logging
 	#if DEBUG
 		logging.setLoglevel(LOGDEBUG);
@@ -15,14 +39,27 @@ NibblerSoundSDL::NibblerSoundSDL() {
 
 NibblerSoundSDL::~NibblerSoundSDL() {
 	logInfo("exit sound SDL");
-	for (auto it = _music.begin(); it != _music.end(); it++) {
-		Mix_FreeMusic(it->second.music);
+	SoundStats stats = getStats();
+	logInfo("sound SDL: " << stats.nbCallbacks << " audio buffers, " << stats.nbUnderruns << " underruns, "
+		<< stats.nbMusicUnderruns << " music underruns, " << stats.nbDroppedCommands << " dropped commands, " << stats.nbStolenVoices << " stolen voices");
+	if (_mixing) {
+		Mix_HookMusic(nullptr, nullptr);
+		Mix_SetPostMix(nullptr, nullptr);
 	}
+	_musicStream.stop();
+	if (_mixMusic != nullptr) {
+		Mix_HaltMusic();
+		Mix_FreeMusic(_mixMusic);
+	}
+	// wait for the background loadings before closing the audio
 	for (auto it = _sound.begin(); it != _sound.end(); it++) {
-		Mix_FreeChunk(it->second.sound);
+		if (it->pending.valid())
+			it->pending.wait();
+		if (it->chunk != nullptr)
+			Mix_FreeChunk(it->chunk);
 	}
 	Mix_CloseAudio();
-    SDL_Quit();
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);  // the SDL GUIs can still use SDL
 }
 
 NibblerSoundSDL::NibblerSoundSDL(NibblerSoundSDL const &src) {
@@ -36,95 +73,433 @@ NibblerSoundSDL &NibblerSoundSDL::operator=(NibblerSoundSDL const &rhs) {
 	return *this;
 }
 
-bool NibblerSoundSDL::_init(int nbSoundChannels) {
+bool NibblerSoundSDL::_init(int nbSoundChannels, int bufferSize) {
 	logInfo("loading sound SDL");
+	_nbChannels = nbSoundChannels;
 
 	if (SDL_Init(SDL_INIT_AUDIO) < 0)
 		return false;
 
-	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, 1024) == -1) {
+	// SDL_mixer works with a power of 2 buffer size
+	int chunkSize = 1;
+	while (chunkSize < bufferSize)
+		chunkSize <<= 1;
+	if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, MIX_DEFAULT_CHANNELS, chunkSize) == -1) {
 		logErr("while loading sound SDL: " << Mix_GetError());
+		return true;
 	}
+	// the sounds are decoded directly in the mixer format
+	Mix_QuerySpec(&_freq, &_format, &_channels);
+	logDebug("sound SDL: " << _freq << "Hz, " << _channels << " channels, buffer of " << chunkSize << " frames");
 
-	Mix_AllocateChannels(nbSoundChannels);
+	if (_format != AUDIO_S16SYS) {
+		// the sounds & the music are played by SDL_mixer (see _playMixSound & _playMixMusic)
+		logWarn("sound SDL: unsupported mixer format " << _format << ", sounds are not mixed & music is not streamed");
+		Mix_AllocateChannels(nbSoundChannels);
+		return true;
+	}
+	// the sounds are mixed in the post mix callback, SDL_mixer channels are not used
+	Mix_AllocateChannels(0);
+	_voices.assign(nbSoundChannels, Voice{nullptr, 0, 0, 0});
+	_mixing = true;
+	Mix_SetPostMix(_postMix, this);
+	// the music replace the SDL_mixer music player
+	_streaming = _musicStream.start(_freq, _format, _channels);
+	if (_streaming)
+		Mix_HookMusic(MusicStream::hook, &_musicStream);
 
-    return true;
+	return true;
 }
 
+/*
+	the music is streamed from the disk when played, only the wav header is checked here
+	the other formats (ogg, mp3, compressed wav, ...) are played by SDL_mixer
+*/
 bool	NibblerSoundSDL::loadMusic(std::string const & name, std::string const & filename, int soundLevel) {
-	Music newMusic;
-	newMusic.filename = filename;
-	newMusic.music = Mix_LoadMUS(filename.c_str());
-	if (newMusic.music == nullptr) {
-		logErr("while loading music " << filename << ": " << Mix_GetError());
+	if (!std::ifstream(filename)) {
+		logErr("while loading music " << filename << ": file not found");
 		return false;
 	}
-	newMusic.vol = soundLevel;
-	_music.insert(std::pair<std::string, Music>(name, newMusic));
+	bool streamed = MusicStream::isValid(filename);
+	if (streamed == false)
+		logDebug("music " << filename << " can't be streamed, it will be played by SDL_mixer");
+	_music[name] = {filename, soundLevel, streamed};
 	return true;
 }
 
 void	NibblerSoundSDL::update() {
 }
 
+/*
+	cut the current music and play this one
+*/
 bool	NibblerSoundSDL::playMusic(std::string const & name, bool infinitePlay) {
-	int nb = (infinitePlay) ? -1 : 1;
+	auto it = _music.find(name);
+	if (it == _music.end()) {
+		logErr("error: music " << name << " is not loaded");
+		return false;
+	}
+	_actMusic = name;
+	if (_streaming == false || it->second.streamed == false)
+		return _playMixMusic(it->second, infinitePlay);
+	_stopMixMusic();
+	_musicStream.play(it->second.filename, it->second.vol, infinitePlay, true);
+	_musicStream.setPaused(false);
+	return true;
+}
 
-	Mix_VolumeMusic(_music[name].vol);
-	if (Mix_PlayMusic(_music[name].music, nb) < 0) {
-		logErr("error: " << Mix_GetError());
+/*
+	play this music right after the current one, without gap
+*/
+bool	NibblerSoundSDL::queueMusic(std::string const & name, bool infinitePlay) {
+	auto it = _music.find(name);
+	if (it == _music.end()) {
+		logErr("error: music " << name << " is not loaded");
 		return false;
 	}
+	// only the stream can queue a music, else it is played now
+	if (_streaming == false || it->second.streamed == false || _mixMusic != nullptr)
+		return playMusic(name, infinitePlay);
 	_actMusic = name;
+	_musicStream.play(it->second.filename, it->second.vol, infinitePlay, false);
 	return true;
 }
 
 bool	NibblerSoundSDL::pause(bool infinitePlay) {
-	if (infinitePlay)
-		Mix_PauseMusic();
-	else
-		Mix_ResumeMusic();
+	if (_mixMusic != nullptr || _streaming == false) {
+		if (infinitePlay)
+			Mix_PauseMusic();
+		else
+			Mix_ResumeMusic();
+		return true;
+	}
+	_musicStream.setPaused(infinitePlay);
 	return true;
 }
 
 bool	NibblerSoundSDL::restart() {
-	Mix_HaltMusic();
-	playMusic(_actMusic);
-	Mix_ResumeMusic();
-	return true;
+	return playMusic(_actMusic);
 }
 
+/*
+	the sound is decoded in background in the mixer format and kept in the asset cache
+	a sound played before the end of decoding is skipped
+*/
 bool	NibblerSoundSDL::loadSound(std::string const & name, std::string const & filename, int soundLevel) {
+	std::string	variant = "pcm_" + std::to_string(_freq) + "_" + std::to_string(_format)
+		+ "_" + std::to_string(_channels);
+	std::string	key = SoundAssetCache::makeKey(filename, variant);
+	if (key.empty()) {
+		logErr("while loading sound " << filename << ": file not found");
+		return false;
+	}
+
+	if (_soundHandles.find(name) != _soundHandles.end()) {
+		logErr("while loading sound " << filename << ": sound " << name << " already loaded");
+		return false;
+	}
+
 	Sound newSound;
 	newSound.filename = filename;
-	newSound.sound = Mix_LoadWAV(filename.c_str());
-	if (newSound.sound == nullptr) {
-		logErr("while loading sound " << filename << ": " << Mix_GetError());
-		return false;
+	newSound.vol = soundLevel;
+	std::vector<uint8_t> const * data = _cache()->find(key);
+	if (data != nullptr) {
+		logDebug("sound " << filename << " loaded from cache");
+		// already decoded, the deferred future is ready
+		newSound.pending = std::async(std::launch::deferred, [data]() { return data; });
+	}
+	else {
+		newSound.pending = std::async(std::launch::async, _decodeSound, _cache(), key, filename,
+			_freq, _format, _channels);
 	}
-	Mix_VolumeChunk(newSound.sound, soundLevel);
-	_sound.insert(std::pair<std::string, Sound>(name, newSound));
+	_soundHandles[name] = _sound.size();
+	_sound.push_back(std::move(newSound));
 	return true;
 }
 
 bool	NibblerSoundSDL::playSound(std::string const & name, int channel) {
-	if (Mix_PlayChannel(channel, _sound[name].sound, 0) < 0) {
+	SoundHandle handle = getSoundHandle(name);
+	if (handle == NO_SOUND_HANDLE) {
+		logErr("error: sound " << name << " is not loaded");
+		return false;
+	}
+	return playSound(handle, channel);
+}
+
+SoundHandle	NibblerSoundSDL::getSoundHandle(std::string const & name) {
+	auto it = _soundHandles.find(name);
+	if (it == _soundHandles.end())
+		return NO_SOUND_HANDLE;
+	return it->second;
+}
+
+/*
+	only send a command to the audio callback: no lock, no allocation, no lookup
+*/
+bool	NibblerSoundSDL::playSound(SoundHandle handle, int channel) {
+	if (handle < 0 || static_cast<size_t>(handle) >= _sound.size()) {
+		logErr("error: invalid sound handle " << handle);
+		return false;
+	}
+	Sound &	sound = _sound[handle];
+
+	if (_loadSound(sound) == false) {
+		if (sound.pending.valid()) {
+			logDebug("sound " << sound.filename << " is still loading");
+			return true;
+		}
+		logErr("error: sound " << sound.filename << " is not loaded");
+		return false;
+	}
+	if (channel < -1 || channel >= _nbChannels) {
+		logErr("error: invalid channel " << channel);
+		return false;
+	}
+	if (_mixing == false)
+		return _playMixSound(sound, channel);
+	Command command = {
+		Command::PLAY,
+		channel,
+		sound.vol,
+		reinterpret_cast<int16_t const *>(sound.data->data()),
+		static_cast<uint32_t>(sound.data->size() / sizeof(int16_t)),
+	};
+	return _pushCommand(command);
+}
+
+bool	NibblerSoundSDL::stopAllSounds() {
+	return stopSound(-1);
+}
+
+bool	NibblerSoundSDL::stopSound(int channel) {
+	if (channel < -1 || channel >= _nbChannels) {
+		logErr("error: invalid channel " << channel);
+		return false;
+	}
+	if (_mixing == false) {
+		Mix_HaltChannel(channel);
+		return true;
+	}
+	return _pushCommand({Command::STOP, channel, 0, nullptr, 0});
+}
+
+SoundStats	NibblerSoundSDL::getStats() const {
+	SoundStats stats;
+	stats.nbCallbacks = _nbCallbacks.load(std::memory_order_relaxed);
+	stats.nbUnderruns = _nbUnderruns.load(std::memory_order_relaxed);
+	stats.nbMusicUnderruns = _musicStream.getUnderruns();
+	stats.nbDroppedCommands = _nbDroppedCommands;
+	stats.nbStolenVoices = _nbStolenVoices.load(std::memory_order_relaxed);
+	return stats;
+}
+
+// -- private -----------------------------------------------------------------
+
+/*
+	the music can't be streamed (file or device format), it is loaded & played by SDL_mixer
+	the music hook replaces the SDL_mixer player, it is removed while this music plays
+*/
+bool	NibblerSoundSDL::_playMixMusic(Music const & music, bool infinitePlay) {
+	if (_mixMusic != nullptr) {
+		Mix_HaltMusic();
+		Mix_FreeMusic(_mixMusic);
+	}
+	else if (_streaming) {
+		_musicStream.halt();
+		Mix_HookMusic(nullptr, nullptr);
+	}
+	_mixMusic = Mix_LoadMUS(music.filename.c_str());
+	if (_mixMusic == nullptr) {
+		logErr("error: " << Mix_GetError());
+		if (_streaming)
+			Mix_HookMusic(MusicStream::hook, &_musicStream);
+		return false;
+	}
+	Mix_VolumeMusic(music.vol);
+	if (Mix_PlayMusic(_mixMusic, (infinitePlay) ? -1 : 1) < 0) {
 		logErr("error: " << Mix_GetError());
 		return false;
 	}
+	Mix_ResumeMusic();
 	return true;
 }
 
-bool	NibblerSoundSDL::stopAllSounds() {
-	Mix_HaltChannel(-1);
+/*
+	the sounds can't be mixed in the device format, they are played on the SDL_mixer channels
+	the chunk uses the decoded samples owned by the cache (no copy)
+*/
+bool	NibblerSoundSDL::_playMixSound(Sound & sound, int channel) {
+	if (sound.chunk == nullptr) {
+		sound.chunk = Mix_QuickLoad_RAW(const_cast<Uint8 *>(sound.data->data()), sound.data->size());
+		if (sound.chunk == nullptr) {
+			logErr("error: " << Mix_GetError());
+			return false;
+		}
+		Mix_VolumeChunk(sound.chunk, sound.vol);
+	}
+	if (Mix_PlayChannel(channel, sound.chunk, 0) < 0) {
+		logErr("error: " << Mix_GetError());
+		return false;
+	}
 	return true;
 }
 
-bool	NibblerSoundSDL::stopSound(int channel) {
-	Mix_HaltChannel(channel);
+/*
+	stop the music played by SDL_mixer and give the output back to the music stream
+*/
+void	NibblerSoundSDL::_stopMixMusic() {
+	if (_mixMusic == nullptr)
+		return;
+	Mix_HaltMusic();
+	Mix_FreeMusic(_mixMusic);
+	_mixMusic = nullptr;
+	Mix_HookMusic(MusicStream::hook, &_musicStream);
+}
+
+SoundAssetCache *	NibblerSoundSDL::_cache() {
+	return (_assetCache != nullptr) ? _assetCache : &_localCache;
+}
+
+/*
+	a deferred future (asset found in cache) is considered ready
+*/
+bool	NibblerSoundSDL::_isReady(AssetFuture & future) {
+	return future.valid() && future.wait_for(std::chrono::seconds(0)) != std::future_status::timeout;
+}
+
+/*
+	get the cached samples, return false if it is not decoded yet or if the decoding failed
+*/
+bool	NibblerSoundSDL::_loadSound(Sound & sound) {
+	if (sound.data == nullptr && _isReady(sound.pending))
+		sound.data = sound.pending.get();
+	return sound.data != nullptr;
+}
+
+bool	NibblerSoundSDL::_pushCommand(Command const & command) {
+	if (_commands.push(command) == false) {
+		_nbDroppedCommands++;
+		logDebug("sound command queue full");
+		return false;
+	}
 	return true;
 }
 
+/*
+	audio thread: apply the commands from the game thread then add the voices over the SDL_mixer output
+*/
+void	NibblerSoundSDL::_postMix(void * udata, Uint8 * stream, int len) {
+	NibblerSoundSDL *	self = reinterpret_cast<NibblerSoundSDL *>(udata);
+	Uint64				now = SDL_GetPerformanceCounter();
+	uint32_t			nbSamples = len / sizeof(int16_t);
+
+	// the previous buffer was filled too long ago: the device ran out of data
+	uint64_t nbFrames = nbSamples / self->_channels;
+	Uint64 maxDelay = self->_perfFreq * nbFrames * SOUND_UNDERRUN_RATIO / self->_freq;
+	if (self->_lastCallback != 0 && now - self->_lastCallback > maxDelay)
+		self->_nbUnderruns.fetch_add(1, std::memory_order_relaxed);
+	self->_lastCallback = now;
+	self->_nbCallbacks.fetch_add(1, std::memory_order_relaxed);
+
+	Command command;
+	while (self->_commands.pop(command)) {
+		if (command.type == Command::PLAY) {
+			self->_startVoice(command);
+		}
+		else {
+			for (size_t i = 0; i < self->_voices.size(); i++) {
+				if (command.channel == -1 || static_cast<int>(i) == command.channel)
+					self->_voices[i].samples = nullptr;
+			}
+		}
+	}
+
+	self->_mix(reinterpret_cast<int16_t *>(stream), nbSamples);
+}
+
+/*
+	audio thread: channel -1 take a free voice, or the voice closest to its end if all are used
+*/
+void	NibblerSoundSDL::_startVoice(Command const & command) {
+	int channel = command.channel;
+	if (channel == -1) {
+		uint32_t minRemaining = UINT32_MAX;
+		for (size_t i = 0; i < _voices.size(); i++) {
+			if (_voices[i].samples == nullptr) {
+				channel = i;
+				break;
+			}
+			if (_voices[i].nbSamples - _voices[i].pos < minRemaining) {
+				minRemaining = _voices[i].nbSamples - _voices[i].pos;
+				channel = i;
+			}
+		}
+		if (channel == -1)
+			return;  // no voices
+	}
+	if (_voices[channel].samples != nullptr)
+		_nbStolenVoices.fetch_add(1, std::memory_order_relaxed);
+	_voices[channel] = {command.samples, command.nbSamples, 0, command.vol};
+}
+
+/*
+	audio thread: add all the voices to the stream (signed 16 bits samples)
+*/
+void	NibblerSoundSDL::_mix(int16_t * stream, uint32_t nbSamples) {
+	for (auto it = _voices.begin(); it != _voices.end(); it++) {
+		if (it->samples == nullptr)
+			continue;
+		uint32_t nb = std::min(nbSamples, it->nbSamples - it->pos);
+		int16_t const * samples = it->samples + it->pos;
+		for (uint32_t i = 0; i < nb; i++) {
+			int32_t sample = stream[i] + samples[i] * it->vol / MIX_MAX_VOLUME;
+			stream[i] = std::max(INT16_MIN, std::min(INT16_MAX, sample));
+		}
+		it->pos += nb;
+		if (it->pos >= it->nbSamples)
+			it->samples = nullptr;
+	}
+}
+
+/*
+	decode a wav file and convert it to the mixer format (called in a background thread)
+*/
+std::vector<uint8_t> const *	NibblerSoundSDL::_decodeSound(SoundAssetCache * cache, std::string key,
+std::string filename, int freq, Uint16 format, int channels) {
+	SDL_AudioSpec	spec;
+	Uint8 *			buf;
+	Uint32			len;
+
+	if (SDL_LoadWAV(filename.c_str(), &spec, &buf, &len) == nullptr) {
+		logErr("while loading sound " << filename << ": " << SDL_GetError());
+		return nullptr;
+	}
+
+	SDL_AudioCVT	cvt;
+	if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq, format, channels, freq) < 0) {
+		logErr("while converting sound " << filename << ": " << SDL_GetError());
+		SDL_FreeWAV(buf);
+		return nullptr;
+	}
+
+	std::vector<uint8_t> data(len * cvt.len_mult);
+	std::memcpy(data.data(), buf, len);
+	SDL_FreeWAV(buf);
+	if (cvt.needed) {
+		cvt.buf = data.data();
+		cvt.len = len;
+		if (SDL_ConvertAudio(&cvt) < 0) {
+			logErr("while converting sound " << filename << ": " << SDL_GetError());
+			return nullptr;
+		}
+		data.resize(cvt.len_cvt);
+	}
+	else {
+		data.resize(len);
+	}
+	return cache->insert(key, std::move(data));
+}
+
 extern "C" {
 	ANibblerSound *makeNibblerSoundSDL() {
 		return new NibblerSoundSDL();
@@ -0,0 +1,151 @@
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#include "AllocTracker.hpp"
+#include "Logging.hpp"
+
+static char const * const	subsystemNames[AllocSubsystem::NB_SUBSYSTEMS] = {
+	"other", "input", "move", "food & bonus", "update", "sound", "draw"
+};
+
+// trivial types: no TLS init guard, usable from the first allocation of each thread
+static thread_local AllocTracker::Counts	threadCounts[AllocSubsystem::NB_SUBSYSTEMS];
+static thread_local int						threadSubsystem;
+
+AllocTracker::AllocTracker()
+: _nbTicks(0) {
+	std::memset(_last, 0, sizeof(_last));
+	std::memset(_subsystems, 0, sizeof(_subsystems));
+}
+
+AllocTracker::~AllocTracker() {
+}
+
+AllocTracker::AllocTracker(AllocTracker const &src)
+: AllocTracker() {
+	*this = src;
+}
+
+AllocTracker &AllocTracker::operator=(AllocTracker const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use AllocTracker copy operator");
+	}
+	return *this;
+}
+
+void	AllocTracker::setSubsystem(AllocSubsystem::Enum subsystem) {
+	threadSubsystem = subsystem;
+}
+
+AllocTracker::Counts	AllocTracker::get(AllocSubsystem::Enum subsystem) {
+	return threadCounts[subsystem];
+}
+
+void	AllocTracker::count(size_t size) {
+	threadCounts[threadSubsystem].nbAllocs++;
+	threadCounts[threadSubsystem].nbBytes += size;
+}
+
+uint64_t	AllocTracker::tick() {
+	uint64_t nbAllocs = 0;
+	for (int i = 0; i < AllocSubsystem::NB_SUBSYSTEMS; i++) {
+		Counts		now = threadCounts[i];
+		Subsystem &	subsystem = _subsystems[i];
+		uint64_t	tickAllocs = now.nbAllocs - _last[i].nbAllocs;
+		subsystem.nbAllocs += tickAllocs;
+		subsystem.nbBytes += now.nbBytes - _last[i].nbBytes;
+		if (tickAllocs > subsystem.maxAllocs)
+			subsystem.maxAllocs = tickAllocs;
+		if (tickAllocs > 0)
+			subsystem.nbTicksAllocating++;
+		nbAllocs += tickAllocs;
+		_last[i] = now;
+	}
+	_nbTicks++;
+	return nbAllocs;
+}
+
+void	AllocTracker::reset() {
+	for (int i = 0; i < AllocSubsystem::NB_SUBSYSTEMS; i++)
+		_last[i] = threadCounts[i];
+	std::memset(_subsystems, 0, sizeof(_subsystems));
+	_nbTicks = 0;
+}
+
+/*
+	log the allocations per tick of each subsystem
+*/
+void	AllocTracker::report() const {
+	if (_nbTicks == 0)
+		return;
+
+	std::stringstream	out;  // not ss: name used by the log macros
+	out << "allocations per tick (" << _nbTicks << " ticks):\n";
+	out << std::setw(14) << "subsystem" << std::setw(12) << "allocs" << std::setw(12) << "bytes"
+		<< std::setw(12) << "max allocs" << std::setw(18) << "ticks allocating";
+	out << std::fixed << std::setprecision(2);
+	for (int i = 0; i < AllocSubsystem::NB_SUBSYSTEMS; i++) {
+		Subsystem const & subsystem = _subsystems[i];
+		out << "\n" << std::setw(14) << subsystemNames[i]
+			<< std::setw(12) << static_cast<double>(subsystem.nbAllocs) / _nbTicks
+			<< std::setw(12) << static_cast<double>(subsystem.nbBytes) / _nbTicks
+			<< std::setw(12) << subsystem.maxAllocs
+			<< std::setw(18) << subsystem.nbTicksAllocating;
+	}
+	logInfo(out.str());
+}
+
+// -- operator new -------------------------------------------------------------
+
+/*
+	replace the global allocation functions: all the allocations of the process are counted
+	(the other forms: sized delete, aligned new... call these ones or use malloc directly)
+*/
+void *	operator new(size_t size) {
+	AllocTracker::count(size);
+	while (true) {
+		void * ptr = std::malloc(size > 0 ? size : 1);
+		if (ptr != nullptr)
+			return ptr;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void *	operator new[](size_t size) {
+	return operator new(size);
+}
+
+void *	operator new(size_t size, std::nothrow_t const &) noexcept {
+	try {
+		return operator new(size);
+	}
+	catch (std::bad_alloc const &) {
+		return nullptr;
+	}
+}
+
+void *	operator new[](size_t size, std::nothrow_t const &) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void	operator delete(void * ptr) noexcept {
+	std::free(ptr);
+}
+
+void	operator delete[](void * ptr) noexcept {
+	std::free(ptr);
+}
+
+void	operator delete(void * ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
+
+void	operator delete[](void * ptr, std::nothrow_t const &) noexcept {
+	std::free(ptr);
+}
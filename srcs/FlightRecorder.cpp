@@ -0,0 +1,219 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "FlightRecorder.hpp"
+#include "Logging.hpp"
+
+FlightRecorder	flightRecorder;
+
+static char const * const	eventNames[FlightEvent::NB_EVENTS] = {
+	"TICK_START", "TICK_END", "SLOW_FRAME", "INPUT", "GUI_SWITCH", "SPAWN_FOOD", "SPAWN_BONUS", "SETTINGS_RELOAD"
+};
+static int const			crashSignals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+static char					altStack[1 << 16];  // the handler must work after a stack overflow
+
+/*
+	helpers to format the dump without allocation (async-signal-safe)
+*/
+namespace {
+	struct DumpBuffer {
+		int		fd;
+		char	data[4096];
+		size_t	size;
+
+		void	flush() {
+			size_t written = 0;
+			while (written < size) {
+				ssize_t ret = ::write(fd, data + written, size - written);
+				if (ret <= 0)
+					break;
+				written += ret;
+			}
+			size = 0;
+		}
+		void	add(char const * str) {
+			for (; *str; str++) {
+				if (size == sizeof(data))
+					flush();
+				data[size++] = *str;
+			}
+		}
+		void	add(uint64_t nb) {
+			char	tmp[21];
+			int		i = sizeof(tmp) - 1;
+			tmp[i] = '\0';
+			do {
+				tmp[--i] = '0' + nb % 10;
+				nb /= 10;
+			} while (nb > 0);
+			add(tmp + i);
+		}
+	};
+}
+
+FlightRecorder::FlightRecorder()
+: _events(),
+  _snapshot(),
+  _dumpThread(),
+  _dumping(false),
+  _writePos(0),
+  _startTicks(_ticks()),
+  _startNs(_nowNs()),
+  _lastDumpNs(0),
+  _filename() {}
+
+FlightRecorder::~FlightRecorder() {
+	if (_dumpThread.joinable())
+		_dumpThread.join();
+}
+
+FlightRecorder::FlightRecorder(FlightRecorder const &src)
+: FlightRecorder() {
+	*this = src;
+}
+
+FlightRecorder &FlightRecorder::operator=(FlightRecorder const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use FlightRecorder copy operator");
+	}
+	return *this;
+}
+
+bool	FlightRecorder::start(std::string const & filename) {
+	if (filename.size() >= FLIGHT_RECORDER_PATH_SIZE) {
+		logErr("flight recorder: filename too long " << filename);
+		return false;
+	}
+	std::memcpy(_filename, filename.c_str(), filename.size() + 1);
+
+	stack_t	stack;
+	stack.ss_sp = altStack;
+	stack.ss_size = sizeof(altStack);
+	stack.ss_flags = 0;
+	if (sigaltstack(&stack, nullptr) < 0)
+		logWarn("flight recorder: unable to set the signal stack: " << strerror(errno));
+
+	struct sigaction	action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = &FlightRecorder::_signalHandler;
+	action.sa_flags = SA_ONSTACK | SA_RESETHAND;  // the default handler is called after the dump
+	sigemptyset(&action.sa_mask);
+	for (int sig : crashSignals) {
+		if (sigaction(sig, &action, nullptr) < 0) {
+			logErr("flight recorder: unable to catch signal " << sig << ": " << strerror(errno));
+			return false;
+		}
+	}
+	return true;
+}
+
+bool	FlightRecorder::dump(char const * reason) {
+	return _write(_events, _writePos.load(std::memory_order_acquire), reason);
+}
+
+/*
+	the dump is skipped if a GUI switch happened in the frame (window & audio device creation are always slow)
+	or if the previous dump is still being written
+*/
+bool	FlightRecorder::dumpSlowFrame(uint32_t frameMs) {
+	record(FlightEvent::SLOW_FRAME, 0, frameMs);
+	uint64_t now = _nowNs();
+	if (_lastDumpNs != 0 && now - _lastDumpNs < FLIGHT_DUMP_INTERVAL_MS * 1000000ull)
+		return false;
+	uint64_t end = _writePos.load(std::memory_order_relaxed);
+	for (uint64_t i = end; i > 0 && end - i < FLIGHT_RECORDER_SIZE; i--) {
+		Event const & event = _events[(i - 1) & (FLIGHT_RECORDER_SIZE - 1)];
+		if (event.type == FlightEvent::GUI_SWITCH)
+			return false;
+		if (event.type == FlightEvent::TICK_START)
+			break;
+	}
+	if (_dumping.load(std::memory_order_acquire))
+		return false;
+	if (_dumpThread.joinable())
+		_dumpThread.join();
+	_lastDumpNs = now;
+	std::memcpy(_snapshot, _events, sizeof(_events));
+	_dumping.store(true, std::memory_order_release);
+	_dumpThread = std::thread(&FlightRecorder::_dumpSnapshot, this, end, frameMs);
+	return true;
+}
+
+// -- private -----------------------------------------------------------------
+
+/*
+	write the events as text, oldest first. times are in us since the start of the program
+*/
+bool	FlightRecorder::_write(Event const * events, uint64_t end, char const * reason) {
+	if (_filename[0] == '\0')
+		return false;
+	int fd = open(_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+
+	uint64_t	begin = (end > FLIGHT_RECORDER_SIZE) ? end - FLIGHT_RECORDER_SIZE : 0;
+	// convert the ticks using the time elapsed since the start
+	uint64_t	nowTicks = _ticks();
+	uint64_t	nowNs = _nowNs();
+	double		nsPerTick = (nowTicks > _startTicks)
+		? static_cast<double>(nowNs - _startNs) / (nowTicks - _startTicks) : 1.0;
+
+	DumpBuffer	buf;
+	buf.fd = fd;
+	buf.size = 0;
+	buf.add("# flight recorder: ");
+	buf.add(reason);
+	buf.add("\n# ");
+	buf.add(end - begin);
+	buf.add(" events, ");
+	buf.add((nowNs - _startNs) / 1000);
+	buf.add("us since start\n# timeUs event a b\n");
+	for (uint64_t i = begin; i < end; i++) {
+		Event const & event = events[i & (FLIGHT_RECORDER_SIZE - 1)];
+		uint64_t ticks = (event.ticks > _startTicks) ? event.ticks - _startTicks : 0;
+		buf.add(static_cast<uint64_t>(ticks * nsPerTick / 1000));
+		buf.add(" ");
+		buf.add(event.type < FlightEvent::NB_EVENTS ? eventNames[event.type] : "UNKNOWN");
+		buf.add(" ");
+		buf.add(static_cast<uint64_t>(event.a));
+		buf.add(" ");
+		buf.add(static_cast<uint64_t>(event.b));
+		buf.add("\n");
+	}
+	buf.flush();
+	close(fd);
+	return true;
+}
+
+/*
+	dump thread: write the copy of the ring made by dumpSlowFrame
+*/
+void	FlightRecorder::_dumpSnapshot(uint64_t end, uint32_t frameMs) {
+	if (_write(_snapshot, end, "slow frame")) {
+		logWarn("slow frame (" << frameMs << "ms), last events written in " << _filename);
+	}
+	else {
+		logWarn("flight recorder: unable to write " << _filename);
+	}
+	_dumping.store(false, std::memory_order_release);
+}
+
+uint64_t	FlightRecorder::_nowNs() {
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void	FlightRecorder::_signalHandler(int sig) {
+	char const * reason = "signal";
+	if (sig == SIGSEGV) reason = "crash (SIGSEGV)";
+	else if (sig == SIGABRT) reason = "crash (SIGABRT)";
+	else if (sig == SIGBUS) reason = "crash (SIGBUS)";
+	else if (sig == SIGFPE) reason = "crash (SIGFPE)";
+	else if (sig == SIGILL) reason = "crash (SIGILL)";
+	flightRecorder.dump(reason);
+	raise(sig);  // SA_RESETHAND: default action (core dump)
+}
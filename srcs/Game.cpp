@@ -1,15 +1,41 @@
 #include <stdlib.h>
+#include <future>
 #include "Game.hpp"
 #include "nibbler.hpp"
+#include "FlightRecorder.hpp"
+#include "HeadlessGui.hpp"
+
+// name & setting of each GameSound
+static char const * const	soundNames[GameSound::NB_SOUNDS] = {"win", "loose", "eat", "bonus", "wall"};
+static char const * const	soundSettings[GameSound::NB_SOUNDS] = {
+	"soundWin", "soundLoose", "soundEat", "soundBonus", "soundWall"
+};
 
 Game::Game() :
   dynSoundManager(),
   dynGuiManager(),
+  _settings(loadGameSettings(s)),
+  _settingsWatcher(),
   _gameInfo(nullptr),
   _needExtend(),
-  _speedMs(s.u("speedMs")) {}
+  _speedMs(_settings.speedMs),
+  _soundCache(),
+  _tracer(),
+  _perf(),
+  _metrics(),
+  _allocs(),
+  _highScore(&userData.u("highScore")),
+  _loopTime(0),
+  _lastMoveTime(0),
+  _nbMoves(0),
+  _nextFrame(),
+  _firstLoop(true),
+  _fixedStep(false) {
+	for (int i = 0; i < GameSound::NB_SOUNDS; i++)
+		_sounds[i] = NO_SOUND_HANDLE;
+}
 
-bool Game::init() {
+void Game::_initGameInfo() {
 	_gameInfo = new GameInfo(s.u("nbPlayers") + s.j("ai").u("nbAI"));
 	_gameInfo->realWidth = s.j("screen").u("width");
 	_gameInfo->realHeight = s.j("screen").u("height");
@@ -34,10 +60,28 @@ bool Game::init() {
 			_gameInfo->isIA[i] = true;
 		}
 	}
+}
 
+bool Game::init() {
+	_tracer.setEnabled(s.s("traceFile").empty() == false || s.b("startupProfile"));
+	TRACE_SCOPE(&_tracer, "Game::init");
+	_initGameInfo();
+	dynGuiManager.setTracer(&_tracer);
+	dynSoundManager.setTracer(&_tracer);
+	if (s.b("perfCounters"))
+		_perf.start();  // counters of the game thread: init & run are on the same thread
+	if (s.s("metricsSocket").empty() == false)
+		_metrics.start(s.s("metricsSocket"));
 	try {
 		// this will load GUI et SOUND
+		dynGuiManager.setResident(s.b("residentGui"));
+		dynSoundManager.setResident(s.b("residentGui"));
 		_changeGui(s.u("startGui"), s.u("startSound"));
+		// dlopen the other GUIs in background (they are constructed & initialized on the first switch)
+		for (uint8_t id = 0; id < dynGuiManager.getNbDyn(); id++) {
+			if (id != dynGuiManager.getCurrentID())
+				dynGuiManager.preload(id);
+		}
 	}
 	catch(DynManager<ANibblerGui>::DynManagerException const & e) {
 		logErr(e.what());
@@ -53,15 +97,17 @@ bool Game::init() {
 	}
 
 	restart();
+	if (s.b("reloadSettings"))
+		_settingsWatcher.start(SETTINGS_FILE, s);
 	return true;
 }
 
 void Game::restart() {
 	_gameInfo->restart();
-	_gameInfo->paused = s.b("pauseOnStart");
-	_speedMs = s.u("speedMs");
-	if (s.u("snakeSize") > userData.u("highScore")) {
-		userData.u("highScore") = s.u("snakeSize");
+	_gameInfo->paused = _settings.pauseOnStart;
+	_speedMs = _settings.speedMs;
+	if (_settings.snakeSize > *_highScore) {
+		*_highScore = _settings.snakeSize;
 	}
 	int startY = _gameInfo->boardSize / 2;
 	for (int id = 0; id < _gameInfo->nbPlayers; id++) {
@@ -70,7 +116,7 @@ void Game::restart() {
 		_gameInfo->direction[id] = (id & 1) ? Direction::MOVE_UP : Direction::MOVE_DOWN;
 		_gameInfo->snakes[id].clear();
 		_gameInfo->nbBonus[id] = 0;
-		for (int y = 0; y < static_cast<int>(s.u("snakeSize")); y++) {
+		for (int y = 0; y < static_cast<int>(_settings.snakeSize); y++) {
 			int posY = startY + ((id & 1) ? y : -y);
 			_gameInfo->snakes[id].push_back({startX, posY});
 		}
@@ -86,9 +132,9 @@ Game::Game(Game const &src) {
 }
 
 Game::~Game() {
+	dynGuiManager.unloadAll();
+	dynSoundManager.unloadAll();
 	delete _gameInfo;
-	dynGuiManager.unload();
-	dynSoundManager.unload();
 }
 
 Game &Game::operator=(Game const &rhs) {
@@ -98,60 +144,200 @@ Game &Game::operator=(Game const &rhs) {
 }
 
 void Game::run() {
-	float						loopTime = 1000 / s.j("screen").u("fps");
-	std::chrono::milliseconds	time_start;
-	uint32_t					lastMoveTime = 0;
-	uint32_t					nbMoves = 0;
-	#if DEBUG_FPS_LOW == true
-		bool firstLoop = true;
-	#endif
-	while (dynGuiManager.obj->input.quit == false) {
-		time_start = getMs();
-
-		dynGuiManager.obj->updateInput();
-
-		// move snake
-		uint32_t now = getMs().count();
-		if (_gameInfo->paused == false && now - lastMoveTime > _speedMs) {
-			for (int id = 0; id < _gameInfo->nbPlayers; id++) {
-				if (_gameInfo->isIA[id])
-					_moveIA(_gameInfo->direction[id], id);
-				else
-					_move(_gameInfo->direction[id], id);
-			}
-			_updateWall();
-			nbMoves++;
-			if (s.i("increasingSpeedStep") != -1 && nbMoves % s.i("increasingSpeedStep") == 0) {
-				if (_speedMs > s.u("maxSpeedMs"))
-					_speedMs--;
+	_loopTime = 1000 / _settings.fps;
+	_nextFrame = std::chrono::steady_clock::now();
+	_firstLoop = true;
+	while (dynGuiManager.obj->input.quit == false)
+		_tick();
+	if (_tracer.isEnabled())
+		_tracer.save(s.s("traceFile"));
+	_perf.report();
+	if (s.b("allocReport"))
+		_allocs.report();
+}
+
+/*
+	headless game (no window, sound OFF, all the snakes played by the AI) with one move per tick
+	the ticks are the ones of run(): after the warmup, no tick can allocate (the deques recycle their chunks,
+	the settings are resolved before...)
+*/
+bool Game::checkAllocs() {
+	_initGameInfo();
+	for (int id = 0; id < _gameInfo->nbPlayers; id++)
+		_gameInfo->isIA[id] = true;
+	try {
+		dynSoundManager.load(0);  // sound OFF
+		if (dynSoundManager.obj->init(10, s.u("soundBufferSize")) == false)
+			throw GameException("unable to load Sound");
+	}
+	catch(DynManager<ANibblerSound>::DynManagerException const & e) {
+		logErr(e.what());
+		return false;
+	}
+	catch(GameException const & e) {
+		logErr(e.what());
+		return false;
+	}
+	HeadlessGui	gui;
+	dynGuiManager.obj = &gui;  // not owned by the DynManager
+	gui.init(_gameInfo);
+	restart();
+
+	_loopTime = 1000 / _settings.fps;
+	_firstLoop = true;
+	_fixedStep = true;
+	uint32_t	firstAllocTick = 0;
+	uint64_t	firstAllocs = 0;
+	uint64_t	nbAllocatingTicks = 0;
+	for (uint32_t tick = 0; tick < ALLOC_CHECK_WARMUP + ALLOC_CHECK_TICKS; tick++) {
+		if (tick == ALLOC_CHECK_WARMUP)
+			_allocs.reset();
+		uint64_t nbAllocs = _tick();
+		// don't log here: the log would be counted in the next tick
+		if (tick >= ALLOC_CHECK_WARMUP && nbAllocs > 0) {
+			if (nbAllocatingTicks == 0) {
+				firstAllocTick = tick;
+				firstAllocs = nbAllocs;
 			}
-			lastMoveTime = now;
+			nbAllocatingTicks++;
 		}
+	}
+	_fixedStep = false;
+	dynGuiManager.obj = nullptr;
 
-		// update game
-		_updateFood();
-		_updateBonus();
-		_update();
+	_allocs.report();
+	if (nbAllocatingTicks > 0) {
+		logErr(nbAllocatingTicks << " / " << ALLOC_CHECK_TICKS << " ticks allocated (first: tick "
+			<< firstAllocTick << ", " << firstAllocs << " allocations)");
+		return false;
+	}
+	logSuccess("no allocation in " << ALLOC_CHECK_TICKS << " ticks");
+	return true;
+}
 
-		// draw on screen
-		dynGuiManager.obj->draw();
+// -- private -----------------------------------------------------------------
 
-		// fps
-		std::chrono::milliseconds time_loop = getMs() - time_start;
-		if (time_loop.count() > loopTime) {
-			#if DEBUG_FPS_LOW == true
-				if (!firstLoop)
-					logDebug("update loop slow -> " << time_loop.count() << "ms / " << loopTime << "ms ("
-					<< s.j("screen").u("fps") << "fps)");
-			#endif
-		}
-		else {
-			usleep((loopTime - time_loop.count()) * 1000);
-		}
+/*
+	one frame of the game loop: input, move, update, sound, draw then wait for the next frame
+	return the allocations of the tick (the ones after the draw are counted in the next tick)
+*/
+uint64_t Game::_tick() {
+	std::chrono::milliseconds time_start = getMs();
+	std::chrono::steady_clock::time_point frameClock = std::chrono::steady_clock::now();
+	// a tick woken up early by an input only handle it: the frame is drawn at the next deadline
+	bool frameDue = _fixedStep || frameClock >= _nextFrame;
+	flightRecorder.record(FlightEvent::TICK_START, _nbMoves);
+	uint64_t frameStart = _tracer.begin();
+	uint64_t phaseStart = frameStart;
+	PerfCounters::Values perfStart = _perf.read();
+	AllocTracker::setSubsystem(AllocSubsystem::INPUT);
+
+	// apply the reloaded settings between two ticks
+	if (_settingsWatcher.update(_settings)) {
+		_loopTime = 1000 / _settings.fps;
+		_gameInfo->stateVersion++;
+		flightRecorder.record(FlightEvent::SETTINGS_RELOAD);
+	}
+
+	dynGuiManager.obj->updateInput();
+	if (dynGuiManager.obj->input.quit)
+		flightRecorder.record(FlightEvent::INPUT, 0, FlightEvent::QUIT);
+	phaseStart = _tracer.end("input", phaseStart);
+	perfStart = _perf.add(PerfPhase::INPUT, perfStart);
+	AllocTracker::setSubsystem(AllocSubsystem::MOVE);
+
+	// move snake
+	uint32_t now = getMs().count();
+	if (_gameInfo->paused == false && (now - _lastMoveTime > _speedMs || _fixedStep)) {
+		for (int id = 0; id < _gameInfo->nbPlayers; id++) {
+			if (_gameInfo->isIA[id]) {
+				std::chrono::steady_clock::time_point aiStart = std::chrono::steady_clock::now();
+				_moveIA(_gameInfo->direction[id], id);
+				_metrics.addAIDecision(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - aiStart).count());
+			}
+			else
+				_move(_gameInfo->direction[id], id);
+		}
+		_updateWall();
+		_gameInfo->stateVersion++;  // snakes, wall & scores (deaths are checked in _update, before the draw)
+		_nbMoves++;
+		_metrics.addMove();
+		if (_settings.increasingSpeedStep != -1 && _nbMoves % _settings.increasingSpeedStep == 0) {
+			if (_speedMs > _settings.maxSpeedMs)
+				_speedMs--;
+		}
+		_lastMoveTime = now;
+	}
+	phaseStart = _tracer.end("move", phaseStart);
+	perfStart = _perf.add(PerfPhase::MOVE, perfStart);
+	AllocTracker::setSubsystem(AllocSubsystem::FOOD_BONUS);
+
+	// update game
+	_updateFood();
+	_updateBonus();
+	perfStart = _perf.add(PerfPhase::FOOD_BONUS, perfStart);
+	AllocTracker::setSubsystem(AllocSubsystem::UPDATE);
+	_update();
+	uint64_t nbAlive = 0;
+	for (int id = 0; id < _gameInfo->nbPlayers; id++)
+		nbAlive += (_gameInfo->snakes[id].size() > 0);
+	_metrics.setSnakesAlive(nbAlive);
+	phaseStart = _tracer.end("update", phaseStart);
+	perfStart = _perf.add(PerfPhase::UPDATE, perfStart);
+	AllocTracker::setSubsystem(AllocSubsystem::SOUND);
+	dynSoundManager.obj->update();
+	_metrics.setSoundStats(dynSoundManager.obj->getStats());
+	phaseStart = _tracer.end("sound", phaseStart);
+	perfStart = _perf.add(PerfPhase::SOUND, perfStart);
+	AllocTracker::setSubsystem(AllocSubsystem::DRAW);
+
+	// draw on screen (once per frame, only if something changed)
+	bool drawn = frameDue;
+	if (frameDue) {
+		_nextFrame = frameClock + std::chrono::microseconds(static_cast<int64_t>(_loopTime * 1000));
+		if (_settings.renderOnChange)
+			drawn = dynGuiManager.obj->drawIfChanged();
+		else
+			dynGuiManager.obj->draw();
+	}
+	_tracer.end("draw", phaseStart);
+	_tracer.end("frame", frameStart, _nbMoves);
+	_perf.add(PerfPhase::DRAW, perfStart);
+	_perf.tick();
+	AllocTracker::setSubsystem(AllocSubsystem::OTHER);
+	uint64_t nbAllocs = _allocs.tick();
+	if (_firstLoop && s.b("startupProfile")) {
+		uint64_t firstFrameNs = Tracer::nowNs();
+		_tracer.add("launch to first frame", _tracer.getStartNs(), firstFrameNs);
+		_tracer.logSpans("startup", firstFrameNs);
+		_tracer.setEnabled(s.s("traceFile").empty() == false);
+	}
+
+	// fps
+	std::chrono::milliseconds time_loop = getMs() - time_start;
+	flightRecorder.record(FlightEvent::TICK_END, 0, time_loop.count());
+	bool overBudget = _settings.frameBudgetMs > 0
+		&& static_cast<uint64_t>(time_loop.count()) > _settings.frameBudgetMs;
+	if (!_firstLoop && overBudget)
+		flightRecorder.dumpSlowFrame(time_loop.count());
+	_metrics.addFrame(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - frameClock).count(), time_loop.count() > _loopTime, overBudget, drawn);
+	if (time_loop.count() > _loopTime) {
 		#if DEBUG_FPS_LOW == true
-			firstLoop = false;
+			if (!_firstLoop)
+				logDebug("update loop slow -> " << time_loop.count() << "ms / " << _loopTime << "ms ("
+				<< _settings.fps << "fps)");
 		#endif
 	}
+	std::chrono::steady_clock::time_point tickEnd = std::chrono::steady_clock::now();
+	if (tickEnd < _nextFrame) {
+		// wake up on the first input: a key press is handled without waiting the end of the frame
+		dynGuiManager.obj->waitInput(static_cast<uint32_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(_nextFrame - tickEnd).count()));
+	}
+	_firstLoop = false;
+	return nbAllocs;
 }
 
 void Game::_updateFood() {
@@ -161,12 +347,16 @@ void Game::_updateFood() {
 		if (it != _gameInfo->food.end()) {  // if snake is eating
 			_needExtend[id]++;
 			_gameInfo->food.erase(it);
+			_gameInfo->stateVersion++;
+			_playSound(GameSound::EAT);
 		}
 	}
 
 	// add food
-	while (_gameInfo->food.size() < s.u("nbFood")) {
-		for (int i = 0; i < 100; i++) {
+	while (_gameInfo->food.size() < _settings.nbFood) {
+		size_t	nbFood = _gameInfo->food.size();
+		int		i;
+		for (i = 0; i < 100; i++) {
 			Vec2 newFood = {
 				static_cast<int>(rand() % _gameInfo->boardSize),
 				static_cast<int>(rand() % _gameInfo->boardSize),
@@ -192,9 +382,12 @@ void Game::_updateFood() {
 			}
 			if (ok) {  // no snakes on the food
 				_gameInfo->food.push_back(newFood);
+				_gameInfo->stateVersion++;
 				break;
 			}
 		}
+		flightRecorder.record(FlightEvent::SPAWN_FOOD, i + 1, _gameInfo->food.size() > nbFood);
+		_metrics.addSpawn(std::min(i + 1, 100), _gameInfo->food.size() > nbFood);
 	}
 }
 
@@ -208,12 +401,16 @@ void Game::_updateBonus() {
 		if (it != _gameInfo->bonus.end()) {  // if snake is gettting a bonus
 			_gameInfo->nbBonus[id]++;
 			_gameInfo->bonus.erase(it);
+			_gameInfo->stateVersion++;
+			_playSound(GameSound::BONUS);
 		}
 	}
 
 	// add bonus
-	while (_gameInfo->bonus.size() < s.u("nbBonus")) {
-		for (int i = 0; i < 100; i++) {
+	while (_gameInfo->bonus.size() < _settings.nbBonus) {
+		size_t	nbBonus = _gameInfo->bonus.size();
+		int		i;
+		for (i = 0; i < 100; i++) {
 			Vec2 newBonus = {
 				static_cast<int>(rand() % _gameInfo->boardSize),
 				static_cast<int>(rand() % _gameInfo->boardSize),
@@ -239,9 +436,12 @@ void Game::_updateBonus() {
 			}
 			if (ok) {  // no snakes on the bonus
 				_gameInfo->bonus.push_back(newBonus);
+				_gameInfo->stateVersion++;
 				break;
 			}
 		}
+		flightRecorder.record(FlightEvent::SPAWN_BONUS, i + 1, _gameInfo->bonus.size() > nbBonus);
+		_metrics.addSpawn(std::min(i + 1, 100), _gameInfo->bonus.size() > nbBonus);
 	}
 }
 
@@ -267,6 +467,7 @@ then, change direction if:
 go to a direction without obstacle or in a random direction (~ every aiStrength)
 */
 void Game::_moveIA(Direction::Enum lastDir, int id) {
+	TRACE_SCOPE(&_tracer, "moveIA", id);
 	Vec2	forward;
 	bool	isFood = false;
 	int		foodDir;
@@ -349,7 +550,7 @@ void Game::_moveIA(Direction::Enum lastDir, int id) {
 	Direction::Enum dir = lastDir;
 	if (isFood)
 		dir = static_cast<Direction::Enum>(foodDir);
-	else if (possibleDir[lastDir] == false || rand() % s.j("ai").u("changeDirProba") == 0) {
+	else if (possibleDir[lastDir] == false || rand() % _settings.aiChangeDirProba == 0) {
 		int order[4] = {0, 1, 2, 3};
 		for (int i = 0; i < 30; i++) {
 			int id1 = rand() % 4;
@@ -359,7 +560,7 @@ void Game::_moveIA(Direction::Enum lastDir, int id) {
 			order[id2] = tmp;
 		}
 		for (int i = 0; i < 4; i++) {
-			if ((possibleDir[order[i]] && i != lastDir) || rand() % s.j("ai").u("strength") == 0) {
+			if ((possibleDir[order[i]] && i != lastDir) || rand() % _settings.aiStrength == 0) {
 				dir = static_cast<Direction::Enum>(order[i]);
 				break;
 			}
@@ -404,8 +605,8 @@ void Game::_move(Direction::Enum direction, int id) {
 		_gameInfo->snakes[id].push_front(newVec2);
 		if (_needExtend[id] > 0) {
 			_needExtend[id]--;
-			if (_gameInfo->snakes[id].size() > userData.u("highScore")) {
-				userData.u("highScore") = _gameInfo->snakes[id].size();
+			if (_gameInfo->snakes[id].size() > *_highScore) {
+				*_highScore = _gameInfo->snakes[id].size();
 			}
 		}
 		else {
@@ -413,50 +614,108 @@ void Game::_move(Direction::Enum direction, int id) {
 			_gameInfo->snakes[id].pop_back();
 			if (dynGuiManager.obj->input.usingBonus[id] && _gameInfo->nbBonus[id] > 0) {
 				_gameInfo->nbBonus[id]--;
-				_gameInfo->wall.push_back({_lastDeletedSnake[id], static_cast<int>(s.i("wallLife"))});
+				_gameInfo->wall.push_back({_lastDeletedSnake[id], static_cast<int>(_settings.wallLife)});
+				_playSound(GameSound::WALL);
 			}
 		}
 	}
 }
 
 void Game::_changeGui(int guiID, int soundID) {
+	std::chrono::steady_clock::time_point switchStart = std::chrono::steady_clock::now();
+	flightRecorder.record(FlightEvent::GUI_SWITCH,
+		(dynGuiManager.obj != nullptr) ? dynGuiManager.getCurrentID() : 0xFFFF, guiID);
 	_gameInfo->paused = true;
 
-	dynSoundManager.unload();
-	dynGuiManager.unload();
+	if (dynGuiManager.obj != nullptr)
+		dynGuiManager.obj->setActive(false);
+
+	// the SDL subsystems are not thread safe: the sound backend is loaded, initialized (audio device) and
+	// deleted on this thread, only its assets (music & sounds files) are loaded on a worker thread
+	// while the GUI creates its window
+	std::future<void> soundAssets;
+	if (soundID != dynSoundManager.getCurrentID()) {
+		TRACE_SCOPE(&_tracer, "load sound", soundID);
+		// in resident mode, load return false if the sound was already loaded & initialized
+		if (dynSoundManager.load(soundID)) {
+			dynSoundManager.obj->setAssetCache(&_soundCache);
+			{
+				TRACE_SCOPE(&_tracer, "sound init");
+				if (dynSoundManager.obj->init(10, s.u("soundBufferSize")) == false)
+					throw GameException("unable to load Sound");
+			}
+			soundAssets = std::async(std::launch::async, &Game::_loadSoundAssets, this);
+		}
+	}
 
-	dynSoundManager.load(soundID);
-	if (dynSoundManager.obj->init() == false)
-		throw GameException("unable to load Sound");
+	// in resident mode, an already initialized GUI is only shown again
+	{
+		TRACE_SCOPE(&_tracer, "load GUI", guiID);
+		if (dynGuiManager.load(guiID)) {
+			dynGuiManager.obj->setTracer(&_tracer);
+			if (dynGuiManager.obj->init(_gameInfo) == false)
+				throw GameException("unable to load GUI");  // the future destructor waits for the sound thread
+		}
+	}
+	if (soundAssets.valid()) {
+		{
+			TRACE_SCOPE(&_tracer, "wait sound");
+			soundAssets.get();  // throw the errors of the sound thread
+		}
+		dynSoundManager.obj->playMusic("masterMusic");
+		dynSoundManager.obj->restart();
+	}
+	// handles are only valid for the current sound backend
+	for (int i = 0; i < GameSound::NB_SOUNDS; i++)
+		_sounds[i] = dynSoundManager.obj->getSoundHandle(soundNames[i]);
+	dynGuiManager.obj->setActive(true);
+	_metrics.addGuiSwitch(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - switchStart).count());
+}
 
+/*
+	called on a worker thread by _changeGui: only read the assets files (no SDL call, no game state)
+	the sounds are decoded in background by the sound backend
+*/
+void Game::_loadSoundAssets() {
+	TRACE_SCOPE(&_tracer, "load sound assets");
 	if (dynSoundManager.obj->loadMusic("masterMusic", s.s("masterMusic"), s.u("musicLevel")) == false)
 		throw GameException("unable to load Sound");
-	if (dynSoundManager.obj->loadSound("win", s.s("soundWin"), s.u("soundLevel")) == false)
-		throw GameException("unable to load Sound");
-	if (dynSoundManager.obj->loadSound("loose", s.s("soundLoose"), s.u("soundLevel")) == false)
-		throw GameException("unable to load Sound");
-	dynSoundManager.obj->playMusic("masterMusic");
-	dynSoundManager.obj->restart();
-
-	dynGuiManager.load(guiID);
-	if (dynGuiManager.obj->init(_gameInfo) == false)
-		throw GameException("unable to load GUI");
+	for (int i = 0; i < GameSound::NB_SOUNDS; i++) {
+		if (s.s(soundSettings[i]).empty())
+			continue;  // optional sound
+		if (dynSoundManager.obj->loadSound(soundNames[i], s.s(soundSettings[i]), s.u("soundLevel")) == false)
+			throw GameException("unable to load Sound");
+	}
+}
 
-	dynGuiManager.obj->input.loadGuiID = NO_GUI_LOADED;
+void Game::_playSound(GameSound::Enum sound, int channel) {
+	if (_sounds[sound] != NO_SOUND_HANDLE)
+		dynSoundManager.obj->playSound(_sounds[sound], channel);
 }
 
 void Game::_update() {
 	// restart
 	if (dynGuiManager.obj->input.restart == true) {
 		dynGuiManager.obj->input.restart = false;
+		flightRecorder.record(FlightEvent::INPUT, 0, FlightEvent::RESTART);
 		restart();
 		return;
 	}
 
+	// save the trace (hotkey)
+	if (dynGuiManager.obj->input.saveTrace) {
+		dynGuiManager.obj->input.saveTrace = false;
+		if (_tracer.isEnabled())
+			_tracer.save(s.s("traceFile"));
+		else
+			logWarn("tracing is disabled, start with --trace <file.json>");
+	}
+
 	// change GUI
 	if (dynGuiManager.obj->input.loadGuiID < dynGuiManager.getNbDyn() && \
 	dynGuiManager.obj->input.loadGuiID != dynGuiManager.getCurrentID()) {
-		_changeGui(dynGuiManager.obj->input.loadGuiID, s.u("startSound"));
+		_changeGui(dynGuiManager.obj->input.loadGuiID, _settings.startSound);
 	}
 
 	bool lastGameOver = _gameInfo->gameOver;
@@ -467,13 +726,15 @@ void Game::_update() {
 	else {
 		_updateMultiPlayer();
 	}
+	if (lastGameOver != _gameInfo->gameOver || lastWin != _gameInfo->win)
+		_gameInfo->stateVersion++;
 	if (lastGameOver == false && _gameInfo->gameOver) {
 		dynSoundManager.obj->pause(true);
-		dynSoundManager.obj->playSound("loose");
+		_playSound(GameSound::LOOSE, 0);
 	}
 	else if (lastWin == false && _gameInfo->win) {
 		dynSoundManager.obj->pause(true);
-		dynSoundManager.obj->playSound("win");
+		_playSound(GameSound::WIN, 0);
 	}
 
 	// update scores
@@ -487,6 +748,11 @@ void Game::_update() {
 		_gameInfo->paused = true;
 	}
 	else {
+		if (_gameInfo->paused != dynGuiManager.obj->input.paused) {
+			flightRecorder.record(FlightEvent::INPUT, 0,
+				dynGuiManager.obj->input.paused ? FlightEvent::PAUSE : FlightEvent::UNPAUSE);
+			_gameInfo->stateVersion++;
+		}
 		_gameInfo->paused = dynGuiManager.obj->input.paused;
 	}
 
@@ -515,10 +781,12 @@ void Game::_update() {
 				else if (dynGuiManager.obj->input.direction[id] == Direction::MOVE_RIGHT && direction.x != -1)
 					_gameInfo->direction[id] = dynGuiManager.obj->input.direction[id];
 			}
+			if (_gameInfo->direction[id] == dynGuiManager.obj->input.direction[id])
+				flightRecorder.record(FlightEvent::INPUT, id, _gameInfo->direction[id]);
 		}
 	}
 
-	_gameInfo->bestScore = userData.u("highScore");
+	_gameInfo->bestScore = *_highScore;
 }
 
 void Game::_updateSinglePlayer() {
@@ -0,0 +1,40 @@
+#include "HeadlessGui.hpp"
+#include "Logging.hpp"
+
+HeadlessGui::HeadlessGui() : ANibblerGui() {
+}
+
+HeadlessGui::~HeadlessGui() {
+}
+
+HeadlessGui::HeadlessGui(HeadlessGui const &src) : HeadlessGui() {
+	*this = src;
+}
+
+HeadlessGui &HeadlessGui::operator=(HeadlessGui const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use HeadlessGui copy operator");
+	}
+	return *this;
+}
+
+void HeadlessGui::updateInput() {
+	input.paused = false;
+	if (_gameInfo->win || _gameInfo->gameOver)
+		input.restart = true;
+}
+
+bool HeadlessGui::draw() {
+	return true;
+}
+
+/*
+	no frame rate: the headless ticks run one after the other
+*/
+void HeadlessGui::waitInput(uint32_t timeoutUs) {
+	(void)timeoutUs;
+}
+
+bool HeadlessGui::_init() {
+	return true;
+}
@@ -0,0 +1,270 @@
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "Metrics.hpp"
+#include "Logging.hpp"
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0  // macos: SO_NOSIGPIPE is set on the client socket
+#endif
+
+// upper bound of each frame time bucket
+static char const * const	bucketNames[METRICS_NB_BUCKETS] = {
+	"0.001", "0.002", "0.005", "0.01", "0.016", "0.033", "0.05", "0.1", "0.25"
+};
+static uint64_t const		bucketUs[METRICS_NB_BUCKETS] = {
+	1000, 2000, 5000, 10000, 16000, 33000, 50000, 100000, 250000
+};
+
+Metrics::Metrics()
+: _nbFrames(0),
+  _frameUs(0),
+  _nbLateFrames(0),
+  _nbOverBudget(0),
+  _nbDrawnFrames(0),
+  _nbMoves(0),
+  _nbAIDecisions(0),
+  _aiDecisionNs(0),
+  _snakesAlive(0),
+  _nbSpawns(0),
+  _nbSpawnRetries(0),
+  _nbSpawnFailures(0),
+  _nbGuiSwitches(0),
+  _guiSwitchUs(0),
+  _soundUnderruns(0),
+  _musicUnderruns(0),
+  _soundDroppedCommands(0),
+  _socketPath(),
+  _thread(),
+  _socketFd(-1),
+  _stopPipe{-1, -1} {
+	for (int i = 0; i <= METRICS_NB_BUCKETS; i++)
+		_frameBuckets[i].store(0, std::memory_order_relaxed);
+}
+
+Metrics::~Metrics() {
+	stop();
+}
+
+Metrics::Metrics(Metrics const &src)
+: Metrics() {
+	*this = src;
+}
+
+Metrics &Metrics::operator=(Metrics const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use Metrics copy operator");
+	}
+	return *this;
+}
+
+/*
+	listen on socketPath, a stale socket of a previous run is replaced (any other file is kept)
+*/
+bool	Metrics::start(std::string const & socketPath) {
+	if (_thread.joinable())
+		return true;
+	struct sockaddr_un	addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(addr.sun_path)) {
+		logWarn("metrics not served: socket path too long " << socketPath);
+		return false;
+	}
+	std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+	struct stat	st;
+	if (lstat(socketPath.c_str(), &st) == 0) {
+		if (!S_ISSOCK(st.st_mode)) {
+			logErr("metrics not served: " << socketPath << " exists and is not a socket");
+			return false;
+		}
+		unlink(socketPath.c_str());
+	}
+
+	_socketFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (_socketFd < 0) {
+		logWarn("metrics not served: " << strerror(errno));
+		return false;
+	}
+	if (bind(_socketFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0)
+		_socketPath = socketPath;  // removed by stop(), only once it is our socket
+	if (_socketPath.empty() || listen(_socketFd, 4) < 0 || pipe(_stopPipe) < 0) {
+		logWarn("metrics not served on " << socketPath << ": " << strerror(errno));
+		stop();
+		return false;
+	}
+	_thread = std::thread(&Metrics::_serveLoop, this);
+	logInfo("metrics served on " << socketPath);
+	return true;
+}
+
+void	Metrics::stop() {
+	if (_thread.joinable()) {
+		// wake up the server thread
+		char c = 0;
+		if (write(_stopPipe[1], &c, 1) < 0)
+			logErr("unable to stop metrics server: " << strerror(errno));
+		_thread.join();
+	}
+	for (int fd : {_socketFd, _stopPipe[0], _stopPipe[1]}) {
+		if (fd >= 0)
+			close(fd);
+	}
+	_socketFd = -1;
+	_stopPipe[0] = -1;
+	_stopPipe[1] = -1;
+	if (!_socketPath.empty())
+		unlink(_socketPath.c_str());
+	_socketPath.clear();
+}
+
+void	Metrics::addFrame(uint64_t frameUs, bool late, bool overBudget, bool drawn) {
+	int bucket = 0;
+	while (bucket < METRICS_NB_BUCKETS && frameUs > bucketUs[bucket])
+		bucket++;
+	_add(_frameBuckets[bucket], 1);
+	_add(_frameUs, frameUs);
+	_add(_nbFrames, 1);
+	if (late)
+		_add(_nbLateFrames, 1);
+	if (overBudget)
+		_add(_nbOverBudget, 1);
+	if (drawn)
+		_add(_nbDrawnFrames, 1);
+}
+
+void	Metrics::addSpawn(uint64_t nbTries, bool spawned) {
+	_add(_nbSpawns, 1);
+	_add(_nbSpawnRetries, nbTries - 1);
+	if (!spawned)
+		_add(_nbSpawnFailures, 1);
+}
+
+void	Metrics::setSoundStats(SoundStats const & stats) {
+	_soundUnderruns.store(stats.nbUnderruns, std::memory_order_relaxed);
+	_musicUnderruns.store(stats.nbMusicUnderruns, std::memory_order_relaxed);
+	_soundDroppedCommands.store(stats.nbDroppedCommands, std::memory_order_relaxed);
+}
+
+/*
+	each value is read once: the total of a histogram can be a few frames ahead of its buckets
+*/
+std::string	Metrics::format() const {
+	std::stringstream	out;  // not ss: name used by the log macros
+	out << std::fixed << std::setprecision(6);
+	auto metric = [&out](char const * name, char const * type, char const * help) {
+		out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+	};
+	auto get = [](std::atomic<uint64_t> const & value) { return value.load(std::memory_order_relaxed); };
+
+	metric("nibbler_frames_total", "counter", "Frames of the game loop.");
+	out << "nibbler_frames_total " << get(_nbFrames) << "\n";
+	metric("nibbler_frame_seconds", "histogram", "Duration of a frame (input, update, sound & draw).");
+	uint64_t cumulative = 0;
+	for (int i = 0; i <= METRICS_NB_BUCKETS; i++) {
+		cumulative += get(_frameBuckets[i]);
+		out << "nibbler_frame_seconds_bucket{le=\"" << (i < METRICS_NB_BUCKETS ? bucketNames[i] : "+Inf") << "\"} "
+			<< cumulative << "\n";
+	}
+	out << "nibbler_frame_seconds_sum " << get(_frameUs) / 1e6 << "\n";
+	out << "nibbler_frame_seconds_count " << cumulative << "\n";
+	metric("nibbler_late_frames_total", "counter", "Frames longer than the fps target.");
+	out << "nibbler_late_frames_total " << get(_nbLateFrames) << "\n";
+	metric("nibbler_over_budget_frames_total", "counter", "Frames longer than frameBudgetMs.");
+	out << "nibbler_over_budget_frames_total " << get(_nbOverBudget) << "\n";
+	metric("nibbler_drawn_frames_total", "counter", "Frames drawn (the others had nothing new to show).");
+	out << "nibbler_drawn_frames_total " << get(_nbDrawnFrames) << "\n";
+	metric("nibbler_moves_total", "counter", "Game ticks (all the snakes moved).");
+	out << "nibbler_moves_total " << get(_nbMoves) << "\n";
+	metric("nibbler_ai_decision_seconds", "summary", "Time spent choosing the direction of an AI snake.");
+	out << "nibbler_ai_decision_seconds_sum " << get(_aiDecisionNs) / 1e9 << "\n";
+	out << "nibbler_ai_decision_seconds_count " << get(_nbAIDecisions) << "\n";
+	metric("nibbler_snakes_alive", "gauge", "Snakes alive on the board.");
+	out << "nibbler_snakes_alive " << get(_snakesAlive) << "\n";
+	metric("nibbler_spawns_total", "counter", "Food & bonus spawned or tried.");
+	out << "nibbler_spawns_total " << get(_nbSpawns) << "\n";
+	metric("nibbler_spawn_retries_total", "counter", "Random positions rejected while spawning food & bonus.");
+	out << "nibbler_spawn_retries_total " << get(_nbSpawnRetries) << "\n";
+	metric("nibbler_spawn_failures_total", "counter", "Food & bonus not spawned (no free position found).");
+	out << "nibbler_spawn_failures_total " << get(_nbSpawnFailures) << "\n";
+	metric("nibbler_gui_switch_seconds", "summary", "Duration of the GUI & sound switches.");
+	out << "nibbler_gui_switch_seconds_sum " << get(_guiSwitchUs) / 1e6 << "\n";
+	out << "nibbler_gui_switch_seconds_count " << get(_nbGuiSwitches) << "\n";
+	// counters of the current sound backend, they restart from 0 after a switch
+	metric("nibbler_audio_underruns_total", "counter", "Audio callbacks called too late (device starved).");
+	out << "nibbler_audio_underruns_total " << get(_soundUnderruns) << "\n";
+	metric("nibbler_music_underruns_total", "counter", "Music buffers not decoded in time.");
+	out << "nibbler_music_underruns_total " << get(_musicUnderruns) << "\n";
+	metric("nibbler_audio_dropped_commands_total", "counter", "Sound commands lost (queue full).");
+	out << "nibbler_audio_dropped_commands_total " << get(_soundDroppedCommands) << "\n";
+	return out.str();
+}
+
+// -- private -----------------------------------------------------------------
+
+void	Metrics::_serveLoop() {
+	pollfd	fds[2] = {
+		{_socketFd, POLLIN, 0},
+		{_stopPipe[0], POLLIN, 0},
+	};
+
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			logErr("metrics server: " << strerror(errno));
+			return;
+		}
+		if (fds[1].revents & POLLIN)
+			return;
+		int clientFd = accept(_socketFd, nullptr, nullptr);
+		if (clientFd < 0)
+			continue;
+		_serve(clientFd);
+		close(clientFd);
+	}
+}
+
+/*
+	minimal HTTP/1.0: read the request headers, answer /metrics whatever the path, close
+*/
+void	Metrics::_serve(int clientFd) {
+	struct timeval	timeout = {METRICS_TIMEOUT_MS / 1000, (METRICS_TIMEOUT_MS % 1000) * 1000};
+	setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+	#ifdef SO_NOSIGPIPE
+		int noSigpipe = 1;
+		setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+	#endif
+
+	std::string	request;
+	char		buffer[512];
+	while (request.size() < METRICS_REQUEST_SIZE && request.find("\r\n\r\n") == std::string::npos
+	&& request.find("\n\n") == std::string::npos) {
+		ssize_t len = recv(clientFd, buffer, sizeof(buffer), 0);
+		if (len <= 0)
+			break;
+		request.append(buffer, len);
+	}
+
+	std::string	body = format();
+	std::string	response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+		+ std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+	if (request.compare(0, 5, "HEAD ") != 0)
+		response += body;
+	size_t sent = 0;
+	while (sent < response.size()) {
+		ssize_t len = send(clientFd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if (len <= 0)
+			return;
+		sent += len;
+	}
+}
@@ -0,0 +1,184 @@
+#include <unistd.h>
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+#endif
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "PerfCounters.hpp"
+#include "Logging.hpp"
+
+static char const * const	counterNames[PerfCounter::NB_COUNTERS] = {
+	"cycles", "instructions", "L1d misses", "LLC misses", "branch misses"
+};
+static char const * const	phaseNames[PerfPhase::NB_PHASES] = {
+	"input", "move", "food & bonus", "update", "sound", "draw"
+};
+
+PerfCounters::PerfCounters()
+: _enabled(false),
+  _nbOpened(0),
+  _nbTicks(0) {
+	for (int i = 0; i < PerfCounter::NB_COUNTERS; i++) {
+		_fds[i] = -1;
+		_groupIdx[i] = -1;
+	}
+	std::memset(_phases, 0, sizeof(_phases));
+}
+
+PerfCounters::~PerfCounters() {
+	stop();
+}
+
+PerfCounters::PerfCounters(PerfCounters const &src)
+: PerfCounters() {
+	*this = src;
+}
+
+PerfCounters &PerfCounters::operator=(PerfCounters const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use PerfCounters copy operator");
+	}
+	return *this;
+}
+
+bool	PerfCounters::start() {
+	#ifdef __linux__
+		if (_enabled)
+			return true;
+		static uint32_t const	types[PerfCounter::NB_COUNTERS] = {
+			PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE
+		};
+		static uint64_t const	configs[PerfCounter::NB_COUNTERS] = {
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_MISSES,
+			PERF_COUNT_HW_BRANCH_MISSES,
+		};
+
+		int leader = -1;
+		for (int i = 0; i < PerfCounter::NB_COUNTERS; i++) {
+			struct perf_event_attr	attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = types[i];
+			attr.config = configs[i];
+			attr.disabled = (leader == -1);  // the whole group is enabled with the leader
+			attr.exclude_kernel = 1;  // allowed with perf_event_paranoid <= 2
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			// this thread only, on any cpu
+			_fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+			if (_fds[i] < 0) {
+				logDebug("perf counter " << counterNames[i] << " not available: " << strerror(errno));
+				continue;
+			}
+			if (leader == -1)
+				leader = _fds[i];
+			_groupIdx[i] = _nbOpened++;
+		}
+		if (leader == -1) {
+			logWarn("perf counters not available (check /proc/sys/kernel/perf_event_paranoid)");
+			return false;
+		}
+		ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		_enabled = true;
+		return true;
+	#else
+		logWarn("perf counters are only available on linux");
+		return false;
+	#endif
+}
+
+void	PerfCounters::stop() {
+	for (int i = 0; i < PerfCounter::NB_COUNTERS; i++) {
+		if (_fds[i] >= 0)
+			close(_fds[i]);
+		_fds[i] = -1;
+		_groupIdx[i] = -1;
+	}
+	_nbOpened = 0;
+	_enabled = false;
+}
+
+/*
+	one read() for the whole group: nr, time enabled, time running, then the values in the opening order
+*/
+PerfCounters::Values	PerfCounters::read() const {
+	Values	values;
+	std::memset(&values, 0, sizeof(values));
+	if (!_enabled)
+		return values;
+
+	uint64_t	buffer[3 + PerfCounter::NB_COUNTERS];
+	int			leader = -1;
+	for (int i = 0; i < PerfCounter::NB_COUNTERS && leader == -1; i++)
+		leader = _fds[i];
+	if (::read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>((3 + _nbOpened) * sizeof(uint64_t)))
+		return values;
+	values.timeEnabled = buffer[1];
+	values.timeRunning = buffer[2];
+	for (int i = 0; i < PerfCounter::NB_COUNTERS; i++) {
+		if (_groupIdx[i] >= 0)
+			values.counters[i] = buffer[3 + _groupIdx[i]];
+	}
+	return values;
+}
+
+PerfCounters::Values	PerfCounters::add(PerfPhase::Enum phase, Values const & start) {
+	if (!_enabled)
+		return start;
+	Values	now = read();
+	uint64_t running = now.timeRunning - start.timeRunning;
+	uint64_t enabled = now.timeEnabled - start.timeEnabled;
+	// the group was not scheduled during the phase: nothing to scale
+	double scale = (running > 0) ? static_cast<double>(enabled) / running : 0;
+
+	_phases[phase].nbCalls++;
+	for (int i = 0; i < PerfCounter::NB_COUNTERS; i++)
+		_phases[phase].counters[i] += (now.counters[i] - start.counters[i]) * scale;
+	return now;
+}
+
+/*
+	log the counters per tick of each phase, with the IPC (instructions / cycles)
+*/
+void	PerfCounters::report() const {
+	if (!_enabled || _nbTicks == 0)
+		return;
+
+	std::stringstream	out;  // not ss: name used by the log macros
+	out << "perf counters per tick (" << _nbTicks << " ticks):\n";
+	out << std::setw(14) << "phase" << std::setw(8) << "IPC";
+	for (int i = 0; i < PerfCounter::NB_COUNTERS; i++)
+		out << std::setw(15) << counterNames[i];
+
+	Phase total;
+	std::memset(&total, 0, sizeof(total));
+	for (int p = 0; p <= PerfPhase::NB_PHASES; p++) {
+		Phase const & phase = (p < PerfPhase::NB_PHASES) ? _phases[p] : total;
+		out << "\n" << std::setw(14) << ((p < PerfPhase::NB_PHASES) ? phaseNames[p] : "total");
+		out << std::fixed << std::setprecision(2) << std::setw(8);
+		if (_groupIdx[PerfCounter::CYCLES] >= 0 && _groupIdx[PerfCounter::INSTRUCTIONS] >= 0
+		&& phase.counters[PerfCounter::CYCLES] > 0)
+			out << phase.counters[PerfCounter::INSTRUCTIONS] / phase.counters[PerfCounter::CYCLES];
+		else
+			out << "n/a";
+		out << std::setprecision(0);
+		for (int i = 0; i < PerfCounter::NB_COUNTERS; i++) {
+			out << std::setw(15);
+			if (_groupIdx[i] >= 0)
+				out << phase.counters[i] / _nbTicks;
+			else
+				out << "n/a";
+			if (p < PerfPhase::NB_PHASES)
+				total.counters[i] += phase.counters[i];
+		}
+	}
+	logInfo(out.str());
+}
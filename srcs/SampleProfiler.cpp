@@ -0,0 +1,259 @@
+#include <cxxabi.h>
+#include <dlfcn.h>
+#ifdef __linux__
+	#include <elf.h>
+#endif
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "SampleProfiler.hpp"
+#include "Logging.hpp"
+
+#define PROFILE_MAX_PROBES 64  // bound the time spent in the signal handler when the table is almost full
+#define PROFILE_SKIP_FRAMES 2  // the signal handler & the signal trampoline
+
+SampleProfiler	sampleProfiler;
+
+SampleProfiler::SampleProfiler()
+: _filename(),
+  _running(false),
+  _stacks(),
+  _nbSamples(0),
+  _nbDropped(0) {}
+
+SampleProfiler::~SampleProfiler() {
+	if (_running)
+		stop();
+}
+
+SampleProfiler::SampleProfiler(SampleProfiler const &src)
+: SampleProfiler() {
+	*this = src;
+}
+
+SampleProfiler &SampleProfiler::operator=(SampleProfiler const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use SampleProfiler copy operator");
+	}
+	return *this;
+}
+
+bool	SampleProfiler::start(std::string const & filename) {
+	if (_running)
+		return true;
+	_filename = filename;
+
+	// the first backtrace loads libgcc (malloc, locks): do it here, not in the signal handler
+	void * frames[PROFILE_MAX_DEPTH];
+	backtrace(frames, PROFILE_MAX_DEPTH);
+
+	struct sigaction	action;
+	std::memset(&action, 0, sizeof(action));
+	action.sa_handler = &SampleProfiler::_signalHandler;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, nullptr) < 0) {
+		logErr("sample profiler: unable to catch SIGPROF: " << strerror(errno));
+		return false;
+	}
+
+	struct itimerval	timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = PROFILE_INTERVAL_US;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, nullptr) < 0) {
+		logErr("sample profiler: unable to start the timer: " << strerror(errno));
+		signal(SIGPROF, SIG_DFL);
+		return false;
+	}
+	_running = true;
+	logInfo("sample profiler started (" << 1000000 / PROFILE_INTERVAL_US << "Hz)");
+	return true;
+}
+
+/*
+	one folded line per stack: "root;caller;...;leaf count"
+*/
+bool	SampleProfiler::stop() {
+	if (!_running)
+		return false;
+	struct itimerval	timer;
+	std::memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	signal(SIGPROF, SIG_IGN);  // a signal can still be pending
+	_running = false;
+
+	ElfCache							elfCache;
+	std::map<void *, std::string>		symbols;
+	std::map<std::string, uint64_t>		folded;  // different addresses can have the same symbols
+	for (Stack const & stack : _stacks) {
+		if (stack.hash.load(std::memory_order_acquire) <= 1)
+			continue;
+		std::string line;
+		for (int i = stack.depth - 1; i >= 0; i--) {
+			auto it = symbols.find(stack.frames[i]);
+			if (it == symbols.end())
+				it = symbols.insert({stack.frames[i], _symbolize(stack.frames[i], elfCache)}).first;
+			if (!line.empty())
+				line += ";";
+			line += it->second;
+		}
+		folded[line] += stack.count.load(std::memory_order_relaxed);
+	}
+
+	std::ofstream	file(_filename);
+	for (auto const & stack : folded)
+		file << stack.first << " " << stack.second << "\n";
+	file.close();
+	if (file.fail()) {
+		logErr("sample profiler: unable to write " << _filename);
+		return false;
+	}
+	logInfo("sample profile: " << _nbSamples.load() << " samples (" << _nbDropped.load() << " dropped), "
+		<< folded.size() << " stacks written in " << _filename);
+	return true;
+}
+
+// -- private -----------------------------------------------------------------
+
+/*
+	signal handler: count the stack in the table (open addressing, the slot is reserved with a CAS)
+*/
+void	SampleProfiler::_addSample(void ** frames, int depth) {
+	_nbSamples.fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t hash = 14695981039346656037ull;  // FNV-1a on the addresses
+	for (int i = 0; i < depth; i++)
+		hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ull;
+	if (hash <= 1)
+		hash += 2;
+
+	for (uint64_t probe = 0; probe < PROFILE_MAX_PROBES; probe++) {
+		Stack &		stack = _stacks[(hash + probe) & (PROFILE_TABLE_SIZE - 1)];
+		uint64_t	current = stack.hash.load(std::memory_order_acquire);
+		if (current == 0) {
+			if (stack.hash.compare_exchange_strong(current, 1, std::memory_order_acquire)) {
+				stack.depth = depth;
+				std::memcpy(stack.frames, frames, depth * sizeof(void *));
+				stack.count.store(1, std::memory_order_relaxed);
+				stack.hash.store(hash, std::memory_order_release);
+				return;
+			}
+		}
+		if (current == hash) {
+			stack.count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+	_nbDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+	function name from the ELF symbol table, or from dladdr (exported symbols only)
+	else library+offset (addr2line can resolve it)
+*/
+std::string	SampleProfiler::_symbolize(void * address, ElfCache & elfCache) {
+	Dl_info	info;
+	Dl_info	mainInfo;
+	// return address: look at the call instruction
+	uintptr_t addr = reinterpret_cast<uintptr_t>(address) - 1;
+	if (dladdr(reinterpret_cast<void *>(addr), &info) == 0 || info.dli_fname == nullptr)
+		return "[unknown]";
+
+	// dli_fname of the executable is argv[0], use the real file
+	std::string filename = info.dli_fname;
+	if (dladdr(reinterpret_cast<void *>(&SampleProfiler::_signalHandler), &mainInfo) != 0
+	&& mainInfo.dli_fbase == info.dli_fbase)
+		filename = "/proc/self/exe";
+	auto elf = elfCache.find(filename);
+	if (elf == elfCache.end()) {
+		elf = elfCache.insert({filename, ElfFile()}).first;
+		_loadElfSymbols(filename, elf->second);
+	}
+	std::vector<ElfSymbol> const & elfSymbols = elf->second.symbols;
+	uint64_t offset = elf->second.absolute ? addr : addr - reinterpret_cast<uintptr_t>(info.dli_fbase);
+	auto it = std::upper_bound(elfSymbols.begin(), elfSymbols.end(), offset,
+		[](uint64_t value, ElfSymbol const & symbol) { return value < symbol.start; });
+	if (it != elfSymbols.begin()) {
+		--it;
+		if (offset < it->start + std::max(it->size, static_cast<uint64_t>(1)))
+			return _demangle(it->name.c_str());
+	}
+
+	if (info.dli_sname != nullptr)
+		return _demangle(info.dli_sname);
+	char const *		libname = std::strrchr(info.dli_fname, '/');
+	std::stringstream	name;
+	name << (libname ? libname + 1 : info.dli_fname) << "+0x" << std::hex
+		<< (reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+	return name.str();
+}
+
+std::string	SampleProfiler::_demangle(char const * name) {
+	int		status;
+	char *	demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	std::string result = (status == 0) ? demangled : name;
+	free(demangled);
+	return result;
+}
+
+/*
+	read the functions of the .symtab section (empty if the file is stripped)
+*/
+void	SampleProfiler::_loadElfSymbols(std::string const & filename, ElfFile & elf) {
+	elf.absolute = false;
+	elf.symbols.clear();
+	#ifdef __linux__
+		std::ifstream		file(filename, std::ios::binary);
+		std::vector<char>	data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (data.size() < sizeof(Elf64_Ehdr))
+			return;
+		Elf64_Ehdr const * header = reinterpret_cast<Elf64_Ehdr const *>(data.data());
+		if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64
+		|| header->e_shentsize != sizeof(Elf64_Shdr)
+		|| header->e_shoff + header->e_shnum * sizeof(Elf64_Shdr) > data.size())
+			return;
+		elf.absolute = (header->e_type == ET_EXEC);
+
+		Elf64_Shdr const * sections = reinterpret_cast<Elf64_Shdr const *>(data.data() + header->e_shoff);
+		for (int i = 0; i < header->e_shnum; i++) {
+			if (sections[i].sh_type != SHT_SYMTAB || sections[i].sh_link >= header->e_shnum)
+				continue;
+			Elf64_Shdr const & strtab = sections[sections[i].sh_link];
+			if (sections[i].sh_offset + sections[i].sh_size > data.size()
+			|| strtab.sh_offset + strtab.sh_size > data.size())
+				continue;
+			Elf64_Sym const * syms = reinterpret_cast<Elf64_Sym const *>(data.data() + sections[i].sh_offset);
+			for (uint64_t s = 0; s < sections[i].sh_size / sizeof(Elf64_Sym); s++) {
+				if (ELF64_ST_TYPE(syms[s].st_info) != STT_FUNC || syms[s].st_value == 0
+				|| syms[s].st_name >= strtab.sh_size)
+					continue;
+				char const * name = data.data() + strtab.sh_offset + syms[s].st_name;
+				elf.symbols.push_back({syms[s].st_value, syms[s].st_size,
+					std::string(name, strnlen(name, strtab.sh_size - syms[s].st_name))});
+			}
+		}
+		std::sort(elf.symbols.begin(), elf.symbols.end(),
+			[](ElfSymbol const & a, ElfSymbol const & b) { return a.start < b.start; });
+	#else
+		(void)filename;
+	#endif
+}
+
+void	SampleProfiler::_signalHandler(int sig) {
+	(void)sig;
+	int		savedErrno = errno;
+	void *	frames[PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES];
+	int		depth = backtrace(frames, PROFILE_MAX_DEPTH + PROFILE_SKIP_FRAMES);
+	if (depth > PROFILE_SKIP_FRAMES)
+		sampleProfiler._addSample(frames + PROFILE_SKIP_FRAMES, depth - PROFILE_SKIP_FRAMES);
+	errno = savedErrno;
+}
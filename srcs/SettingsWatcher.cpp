@@ -0,0 +1,168 @@
+#include <unistd.h>
+#include <poll.h>
+#ifdef __linux__
+	#include <sys/inotify.h>
+#endif
+#include <cstring>
+#include <fstream>
+
+#include "SettingsWatcher.hpp"
+#include "Logging.hpp"
+
+SettingsWatcher::SettingsWatcher()
+: _filename(),
+  _base(),
+  _thread(),
+  _inotifyFd(-1),
+  _stopPipe{-1, -1},
+  _pending(nullptr) {}
+
+SettingsWatcher::~SettingsWatcher() {
+	stop();
+}
+
+SettingsWatcher::SettingsWatcher(SettingsWatcher const &src)
+: SettingsWatcher() {
+	*this = src;
+}
+
+SettingsWatcher &SettingsWatcher::operator=(SettingsWatcher const &rhs) {
+	if (this != &rhs) {
+		logErr("don't use SettingsWatcher copy operator");
+	}
+	return *this;
+}
+
+/*
+	start watching filename, settings is used as base for each reload
+*/
+bool	SettingsWatcher::start(std::string const & filename, SettingsJson const & settings) {
+	#ifdef __linux__
+		if (_thread.joinable())
+			return true;
+
+		// watch the directory: editors often replace the file instead of writing it
+		size_t		slash = filename.find_last_of('/');
+		std::string	dirname = (slash == std::string::npos) ? "." : filename.substr(0, slash);
+		std::string	basename = (slash == std::string::npos) ? filename : filename.substr(slash + 1);
+
+		_inotifyFd = inotify_init1(IN_CLOEXEC);
+		if (_inotifyFd < 0) {
+			logWarn("unable to watch " << filename << ": " << strerror(errno));
+			return false;
+		}
+		if (inotify_add_watch(_inotifyFd, dirname.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0
+		|| pipe(_stopPipe) < 0) {
+			logWarn("unable to watch " << filename << ": " << strerror(errno));
+			close(_inotifyFd);
+			_inotifyFd = -1;
+			return false;
+		}
+		_filename = filename;
+		_base = settings;
+		_thread = std::thread(&SettingsWatcher::_watchLoop, this, dirname, basename);
+		logDebug("watching " << filename);
+		return true;
+	#else
+		(void)settings;
+		logWarn("unable to watch " << filename << ": live reload is only available on linux");
+		return false;
+	#endif
+}
+
+void	SettingsWatcher::stop() {
+	if (_thread.joinable()) {
+		// wake up the watch thread
+		char c = 0;
+		if (write(_stopPipe[1], &c, 1) < 0)
+			logErr("unable to stop settings watcher: " << strerror(errno));
+		_thread.join();
+	}
+	for (int fd : {_inotifyFd, _stopPipe[0], _stopPipe[1]}) {
+		if (fd >= 0)
+			close(fd);
+	}
+	_inotifyFd = -1;
+	_stopPipe[0] = -1;
+	_stopPipe[1] = -1;
+	delete _pending.exchange(nullptr);
+}
+
+bool	SettingsWatcher::update(GameSettings & settings) {
+	GameSettings * newSettings = _pending.exchange(nullptr);
+	if (newSettings == nullptr)
+		return false;
+	settings = *newSettings;
+	delete newSettings;
+	return true;
+}
+
+// -- private -----------------------------------------------------------------
+
+void	SettingsWatcher::_watchLoop(std::string const & dirname, std::string const & basename) {
+	#ifdef __linux__
+		// buffer aligned for inotify_event
+		char	buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+		pollfd	fds[2] = {
+			{_inotifyFd, POLLIN, 0},
+			{_stopPipe[0], POLLIN, 0},
+		};
+
+		while (true) {
+			if (poll(fds, 2, -1) < 0) {
+				if (errno == EINTR)
+					continue;
+				logErr("while watching " << dirname << ": " << strerror(errno));
+				return;
+			}
+			if (fds[1].revents & POLLIN)
+				return;
+
+			ssize_t len = read(_inotifyFd, buffer, sizeof(buffer));
+			if (len <= 0)
+				continue;
+			bool changed = false;
+			for (char * ptr = buffer; ptr < buffer + len;) {
+				struct inotify_event const * event = reinterpret_cast<struct inotify_event const *>(ptr);
+				if (event->len > 0 && basename == event->name)
+					changed = true;
+				ptr += sizeof(struct inotify_event) + event->len;
+			}
+			if (changed)
+				_reload();
+		}
+	#else
+		(void)dirname;
+		(void)basename;
+	#endif
+}
+
+/*
+	load the file over a copy of the base settings, publish it only if the whole file is valid
+*/
+void	SettingsWatcher::_reload() {
+	SettingsJson	settings(_base);
+	try {
+		std::ifstream	fileStream(_filename);
+		nlohmann::json	data;
+		if (!fileStream.is_open()) {
+			logWarn("settings not reloaded: unable to open " << _filename);
+			return;
+		}
+		fileStream >> data;
+		if (settings.loadJson(data, settings) == false) {
+			logWarn("settings not reloaded: invalid values in " << _filename);
+			return;
+		}
+	}
+	catch (std::exception const & e) {
+		logWarn("settings not reloaded: invalid file format " << _filename);
+		return;
+	}
+	// the board is not resized live: snakeSize is clamped against the running board
+	settings.u("boardSize") = _base.u("boardSize");
+
+	// swap with the previous reload if the game didn't apply it yet
+	delete _pending.exchange(new GameSettings(loadGameSettings(settings)));
+	logInfo("settings reloaded from " << _filename);
+}
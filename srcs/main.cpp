@@ -2,18 +2,24 @@
 #include <time.h>
 #include <dlfcn.h>
 #include <iostream>
+#include <exception>
 
 #include "nibbler.hpp"
 #include "Logging.hpp"
 #include "SettingsJson.hpp"
 #include "Game.hpp"
+#include "FlightRecorder.hpp"
+#include "SampleProfiler.hpp"
 
 int start(int ac, char const **av) {
 	(void)ac;
 	(void)av;
+	uint64_t	startNs = Tracer::nowNs();
 	initLogs();  // init logs functions
-	initSettings("assets/settings.json");
+	initSettings(SETTINGS_FILE);
+	uint64_t	settingsNs = Tracer::nowNs();
 	initUserData(s.s("userDataFilename"));
+	uint64_t	userDataNs = Tracer::nowNs();
 
 	s.j("screen").u("height") = s.j("screen").u("width") * HEIGHT_RATIO;
 
@@ -29,8 +35,12 @@ int start(int ac, char const **av) {
 	if (argparse(ac - 1, av + 1) == false)
 		return EXIT_SUCCESS;
 
+	flightRecorder.start(s.s("flightRecorderFile"));
+	if (s.s("sampleProfileFile").empty() == false)
+		sampleProfiler.start(s.s("sampleProfileFile"));
 	srand(time(NULL));
 	Game	game;
+	game.getTracer().setStartNs(startNs);
 
 
 	game.dynSoundManager.addDyn("libNibblerSoundOFF.so", "makeNibblerSoundOFF");
@@ -40,23 +50,44 @@ int start(int ac, char const **av) {
 	game.dynGuiManager.addDyn("libNibblerSFML.so", "makeNibblerSFML");
 	game.dynGuiManager.addDyn("libNibblerOpenGL.so", "makeNibblerOpenGL");
 
+	if (s.b("checkAllocs"))
+		return game.checkAllocs() ? EXIT_SUCCESS : EXIT_FAILURE;
+
 	if (game.init() == false)
 		return EXIT_FAILURE;
+	// measured before the tracer was enabled
+	game.getTracer().add("initSettings", startNs, settingsNs);
+	game.getTracer().add("initUserData", settingsNs, userDataNs);
 
 	try {
 		game.run();
 	}
 	catch(std::exception const & e) {
 		logErr(e.what());
+		sampleProfiler.stop();
 		return EXIT_FAILURE;
 	}
+	// symbolize while the GUI libraries are still loaded
+	sampleProfiler.stop();
 
 	saveUserData(s.s("userDataFilename"));
 	return EXIT_SUCCESS;
 }
 
+static std::terminate_handler	defaultTerminate = nullptr;
+
+/*
+	uncaught exception: write the queued logs before aborting
+*/
+static void	terminateFlush() {
+	logging.flush();
+	defaultTerminate();
+}
+
 int main(int ac, char const **av) {
+	defaultTerminate = std::set_terminate(terminateFlush);
 	int ret = start(ac, av);
+	logging.flush();  // write the queued logs of the exit paths
 
 	return ret;
 }
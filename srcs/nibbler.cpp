@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <unistd.h>
+#include <algorithm>
 #include <chrono>
 
 #include "nibbler.hpp"
@@ -29,9 +30,22 @@ bool	initSettings(std::string const & filename) {
 	s.add<std::string>("masterMusic", "assets/music/masterMusic.wav");
 	s.add<std::string>("soundLoose", "assets/music/loose.wav");
 	s.add<std::string>("soundWin", "assets/music/win.wav");
+	s.add<std::string>("soundEat", "").setDescription("sound when a snake eat (empty to disable)");
+	s.add<std::string>("soundBonus", "").setDescription("sound when a snake get a bonus (empty to disable)");
+	s.add<std::string>("soundWall", "").setDescription("sound when a snake drop a wall (empty to disable)");
+	s.add<std::string>("flightRecorderFile", "flightRecorder.log")
+		.setDescription("file where the last game events are written on crash or slow frame");
+	s.add<std::string>("traceFile", "").disableInFile(true)
+		.setDescription("chrome trace json saved on exit & with F12 (empty to disable, set with --trace)");
+	s.add<std::string>("metricsSocket", "")
+		.setDescription("unix socket where the live metrics are served, prometheus format (empty to disable)");
+	s.add<std::string>("sampleProfileFile", "").disableInFile(true)
+		.setDescription("folded stacks written on exit (empty to disable, set with --sample-profile)");
 	s.add<std::string>("userDataFilename", "assets/userData.json").disableInFile(true);
 
 	s.add<uint64_t>("boardSize", 20).setMin(8).setMax(50).setDescription("size of the snake board");
+	s.add<uint64_t>("frameBudgetMs", 100).setMin(0).setMax(10000)
+		.setDescription("dump the last game events if a frame is longer (0 to disable)");
 	s.add<uint64_t>("maxSpeedMs", 40).setMin(30).setMax(1000).setDescription("maximum speed of the snake");
 	s.add<uint64_t>("musicLevel", 128).setMin(0).setMax(128).setDescription("set the music level");
 	s.add<uint64_t>("nbBonus", 2).setMin(0).setMax(30)
@@ -39,8 +53,11 @@ bool	initSettings(std::string const & filename) {
 	s.add<uint64_t>("nbFood", 1).setMin(0).setMax(30).setDescription("number of food on the board");
 	s.add<uint64_t>("nbPlayers", 1).setMin(1).setMax(2).setDescription("number of players");
 	s.add<uint64_t>("snakeSize", 4).setMin(1).setMax(25).setDescription("starting size of the snake");
+	s.add<uint64_t>("soundBufferSize", 512).setMin(64).setMax(4096)
+		.setDescription("audio buffer size in frames (smaller is lower latency)");
 	s.add<uint64_t>("soundLevel", 128).setMin(0).setMax(128).setDescription("set the sound level");
-	s.add<uint64_t>("speedMs", 100).setMin(30).setMax(1000).setDescription("starting speed of the snake");
+	s.add<uint64_t>("speedMs", 100).setMin(30).setMax(1000)
+		.setDescription("starting speed of the snake (a reloaded value is used from the next restart)");
 	s.add<uint64_t>("startGui", 0).setMin(0).setMax(2).setDescription("id of the startong GUI");
 	s.add<uint64_t>("startSound", 1).setMin(0).setMax(1).setDescription("id of the starting sound (0 for OFF)");
 
@@ -51,6 +68,18 @@ bool	initSettings(std::string const & filename) {
 
 	s.add<bool>("canExitBorder", false).setDescription("if true, the snakes cannot die in front of the borders");
 	s.add<bool>("pauseOnStart", true).setDescription("if true, the game will start in pause mode");
+	s.add<bool>("allocReport", false)
+		.setDescription("if true, log the allocations per tick of each phase on exit");
+	s.add<bool>("startupProfile", false).disableInFile(true)
+		.setDescription("log the duration of each startup phase at the first frame (set with --startup-profile)");
+	s.add<bool>("checkAllocs", false).disableInFile(true)
+		.setDescription("run a headless game and fail if a tick allocates (set with --check-allocs)");
+	s.add<bool>("perfCounters", false)
+		.setDescription("if true, log the hardware counters (IPC, cache & branch misses) per phase on exit");
+	s.add<bool>("reloadSettings", true)
+		.setDescription("if true, the game settings are reloaded when the settings file is modified");
+	s.add<bool>("residentGui", true)
+		.setDescription("if true, the GUIs stay loaded after a switch (switching back is instant)");
 
 	s.add<SettingsJson>("ai");
 		s.j("ai").add<uint64_t>("changeDirProba", 10).setMin(1).setMax(100)
@@ -61,6 +90,8 @@ bool	initSettings(std::string const & filename) {
 	s.add<SettingsJson>("screen");
 		s.j("screen").add<std::string>("name", "nibbler").setDescription("name of the game");
 		s.j("screen").add<uint64_t>("fps", 60).setMin(30).setMax(120).setDescription("framerate");
+		s.j("screen").add<bool>("renderOnChange", true)
+			.setDescription("if true, a frame is drawn only if the game or the view changed (idle CPU near 0)");
 		s.j("screen").add<uint64_t>("width", 1200).setMin(400).setMax(4000).setDescription("width of the screen");
 		s.j("screen").add<uint64_t>("height", 800).setMin(400).setMax(4000).disableInFile(true)
 			.setDescription("height of the screen /!\\ automatically calculed");
@@ -78,6 +109,26 @@ bool	initSettings(std::string const & filename) {
 	return true;
 }
 
+GameSettings	loadGameSettings(SettingsJson const & settings) {
+	GameSettings	gameSettings;
+
+	gameSettings.fps = settings.j("screen").u("fps");
+	gameSettings.speedMs = settings.u("speedMs");
+	gameSettings.maxSpeedMs = settings.u("maxSpeedMs");
+	gameSettings.increasingSpeedStep = settings.i("increasingSpeedStep");
+	gameSettings.snakeSize = std::min(settings.u("snakeSize"), settings.u("boardSize") / 2);
+	gameSettings.nbFood = settings.u("nbFood");
+	gameSettings.nbBonus = settings.u("nbBonus");
+	gameSettings.wallLife = settings.i("wallLife");
+	gameSettings.pauseOnStart = settings.b("pauseOnStart");
+	gameSettings.startSound = settings.u("startSound");
+	gameSettings.aiChangeDirProba = settings.j("ai").u("changeDirProba");
+	gameSettings.aiStrength = settings.j("ai").u("strength");
+	gameSettings.frameBudgetMs = settings.u("frameBudgetMs");
+	gameSettings.renderOnChange = settings.j("screen").b("renderOnChange");
+	return gameSettings;
+}
+
 bool	initUserData(std::string const & filename) {
 	userData.name("userData").description("all informations about the player");
 	userData.add<uint64_t>("highScore", 0);
@@ -108,13 +159,29 @@ bool	saveUserData(std::string const & filename) {
 }
 
 bool	usage() {
-	std::cout << "usage: ./nibbler [-w width] [-h height] [-s] [-u]" << std::endl;
+	std::cout << "usage: ./nibbler [-w width] [-h height] [-t file.json] [-p] [-m socket] [--sample-profile file]"
+		" [--alloc-report] [--check-allocs] [--startup-profile] [-s] [-u]" << std::endl;
 	std::cout << "\t" COLOR_BOLD "-w" COLOR_EOC ", " COLOR_BOLD "--width" COLOR_EOC " <int>: "
 		"set the width of the gui [it's recommended to use this setting in assets/settings]" << std::endl;
 	std::cout << "\t" COLOR_BOLD "-h" COLOR_EOC ", " COLOR_BOLD "--height" COLOR_EOC " <int>: "
 		"set the height of the gui [it's not recommended to use this setting]" << std::endl;
 	std::cout << "\t" COLOR_BOLD "-s" COLOR_EOC ", " COLOR_BOLD "--settings" COLOR_EOC ": "
 		"show the settings list (update in assets/settings.json)" << std::endl;
+	std::cout << "\t" COLOR_BOLD "-t" COLOR_EOC ", " COLOR_BOLD "--trace" COLOR_EOC " <file.json>: "
+		"record the game & GUIs spans, saved on exit & with F12 (chrome://tracing, ui.perfetto.dev)" << std::endl;
+	std::cout << "\t" COLOR_BOLD "-p" COLOR_EOC ", " COLOR_BOLD "--perf-counters" COLOR_EOC ": "
+		"log the hardware counters of each phase of the game loop on exit (linux)" << std::endl;
+	std::cout << "\t" COLOR_BOLD "-m" COLOR_EOC ", " COLOR_BOLD "--metrics" COLOR_EOC " <socket>: "
+		"serve the live metrics on a unix socket (curl --unix-socket <socket> localhost/metrics)" << std::endl;
+	std::cout << "\t" COLOR_BOLD "--sample-profile" COLOR_EOC " <file>: "
+		"sample the cpu usage, the folded stacks are written on exit (flamegraph.pl)" << std::endl;
+	std::cout << "\t" COLOR_BOLD "--alloc-report" COLOR_EOC ": "
+		"log the allocations per tick of each phase of the game loop on exit" << std::endl;
+	std::cout << "\t" COLOR_BOLD "--check-allocs" COLOR_EOC ": "
+		"run a headless game, fail if a tick allocates once the game is running" << std::endl;
+	std::cout << "\t" COLOR_BOLD "--startup-profile" COLOR_EOC ": "
+		"log the duration of each startup phase (settings, libraries, window, shaders...) at the first frame"
+		<< std::endl;
 	std::cout << "\t" COLOR_BOLD "-u" COLOR_EOC ", " COLOR_BOLD "--usage" COLOR_EOC ": "
 		"show usage" << std::endl;
 	return false;
@@ -135,6 +202,36 @@ bool	argparse(int nbArgs, char const **args) {
 				return usage();
 			s.j("screen").update<uint64_t>("width").setValue(atoi(args[i]));
 		}
+		else if (strcmp(args[i], "--trace") == 0 || strcmp(args[i], "-t") == 0) {
+			i++;
+			if (i == nbArgs || args[i][0] == '-')
+				return usage();
+			s.s("traceFile") = args[i];
+		}
+		else if (strcmp(args[i], "--perf-counters") == 0 || strcmp(args[i], "-p") == 0) {
+			s.b("perfCounters") = true;
+		}
+		else if (strcmp(args[i], "--metrics") == 0 || strcmp(args[i], "-m") == 0) {
+			i++;
+			if (i == nbArgs || args[i][0] == '-')
+				return usage();
+			s.s("metricsSocket") = args[i];
+		}
+		else if (strcmp(args[i], "--alloc-report") == 0) {
+			s.b("allocReport") = true;
+		}
+		else if (strcmp(args[i], "--startup-profile") == 0) {
+			s.b("startupProfile") = true;
+		}
+		else if (strcmp(args[i], "--check-allocs") == 0) {
+			s.b("checkAllocs") = true;
+		}
+		else if (strcmp(args[i], "--sample-profile") == 0) {
+			i++;
+			if (i == nbArgs || args[i][0] == '-')
+				return usage();
+			s.s("sampleProfileFile") = args[i];
+		}
 		else if (strcmp(args[i], "--height") == 0 || strcmp(args[i], "-h") == 0) {
 			i++;
 			if (i == nbArgs || args[i][0] == '-')